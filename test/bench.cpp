@@ -0,0 +1,510 @@
+/* Copyright (C) 2015  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// micro-benchmarks of the plugin's callbacks and of every change-detection and wrap kernel the CPU supports - the plugin source is compiled into this driver and runs against the stub XPLM functions of the mock host, every benchmark reports ns/op, time stamp counter cycles/op and allocations/op once with warm caches and once after the plugin's code and data were flushed from all caches, usage: bench <results file> <work folder>
+
+#include "../x_hint.cpp"
+
+#include "xplm_mock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include <link.h>
+
+// define the frame length of the virtual clock
+#define FRAME_TIME (1.0f / 60.0f)
+
+// define the number of operations measured per variant - cold operations each need a cache flush, so there are fewer of them
+#define WARM_OPERATIONS 20000
+#define COLD_OPERATIONS 500
+
+// define the name of the dataref array and command the benchmark watches
+#define BENCH_DATAREF "bench/values"
+#define BENCH_COMMAND "bench/command"
+
+// define the number of hint kinds
+#define HINT_KIND_COUNT (WATCH_KIND_BAROMETER + 1)
+
+// define the number of entries a kernel runs over per operation - a large cockpit's worth of due entries
+#define KERNEL_ENTRIES 4096
+
+// real allocation functions of glibc - the wrappers below count every allocation and forward to them
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+
+// benchmark operation - prepares the plugin outside the measurement, then runs the measured call
+typedef struct
+{
+    const char *name;
+    void (*prepare)(int iteration);
+    void (*run)(int iteration);
+} Benchmark;
+
+// kernel set of one instruction set - only the sets the CPU supports are measured
+typedef struct
+{
+    const char *diffName, *wrapName;
+    DiffKernel diff;
+    WrapKernel wrap;
+} KernelSet;
+
+// global driver variables
+static unsigned long mallocCount = 0;
+static XPLMDataRef benchValues = NULL;
+static int benchWatchCount = 0;
+static FILE *results = NULL;
+static volatile int sink = 0;
+static double cyclesPerNanosecond = 0.0;
+static char benchText[HINT_TEXT_LENGTH];
+static KernelSet kernelSets[4];
+static int kernelSetCount = 0, benchKernelSet = 0;
+static int kernelKeys[KERNEL_ENTRIES], kernelLastKeys[KERNEL_ENTRIES];
+static unsigned int kernelMask[KERNEL_ENTRIES / 32];
+static float kernelInput[KERNEL_ENTRIES], kernelValues[KERNEL_ENTRIES], kernelMins[KERNEL_ENTRIES], kernelRanges[KERNEL_ENTRIES];
+
+extern "C" void *malloc(size_t size)
+{
+    mallocCount++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    mallocCount++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size)
+{
+    mallocCount++;
+    return __libc_realloc(pointer, size);
+}
+
+// return the wall time in seconds
+static double GetWallTime(void)
+{
+    struct timespec wall;
+    clock_gettime(CLOCK_MONOTONIC, &wall);
+    return wall.tv_sec + wall.tv_nsec * 1.0e-9;
+}
+
+// flush a memory range from all cache levels
+static void FlushRange(const void *start, size_t size)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    for (size_t offset = 0; offset < size; offset += 64)
+        _mm_clflush((const char*) start + offset);
+    _mm_mfence();
+#else
+    (void) start;
+    (void) size;
+#endif
+}
+
+// flush the loaded segments of the driver, which hold the plugin's code and static data - the first object reported is the driver itself
+static int FlushProgramSegments(struct dl_phdr_info *info, size_t size, void *data)
+{
+    for (int i = 0; i < info->dlpi_phnum; i++)
+    {
+        if (info->dlpi_phdr[i].p_type == PT_LOAD)
+            FlushRange((const void*) (info->dlpi_addr + info->dlpi_phdr[i].p_vaddr), info->dlpi_phdr[i].p_memsz);
+    }
+
+    return 1;
+}
+
+// flush the plugin's code, its static data and the watch table from all caches - elsewhere a buffer twice the size of the last level cache is written instead
+static void FlushCaches(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    dl_iterate_phdr(FlushProgramSegments, NULL);
+    for (size_t i = 0; i < sizeof(watchArrays) / sizeof(watchArrays[0]); i++)
+        FlushRange(*watchArrays[i].array, watchCapacity * watchArrays[i].elementSize);
+    FlushRange(watchNamePool, watchNamePoolCapacity);
+#else
+    static std::vector<char> buffer;
+    if (buffer.empty())
+    {
+        long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        buffer.resize(size > 0 ? 2 * size : 256 << 20);
+    }
+    for (size_t i = 0; i < buffer.size(); i += 64)
+        buffer[i]++;
+#endif
+}
+
+// start a new frame on the virtual clock
+static void NextFrame(void)
+{
+    MockBeginFrame(MockGetTime() + FRAME_TIME);
+}
+
+// return a knob value that changes with every iteration
+static float GetBenchValue(int iteration)
+{
+    return 0.37f + (float) (iteration % 3600) * 0.1f;
+}
+
+static void PrepareFrame(int iteration)
+{
+    NextFrame();
+}
+
+// keep a poll burst going without changes
+static void PreparePolling(int iteration)
+{
+    NextFrame();
+    if (MockGetTime() >= pollBurstEndTime - 2.0f * FRAME_TIME)
+        MockClick();
+}
+
+// keep a poll burst going and change one knob in every frame
+static void PrepareChange(int iteration)
+{
+    PreparePolling(iteration);
+    MockSetValue(benchValues, iteration % benchWatchCount, GetBenchValue(iteration));
+}
+
+static void RunFlightLoop(int iteration)
+{
+    SchedulerCallback(FRAME_TIME, FRAME_TIME, iteration, NULL);
+}
+
+// show a hint whose text is already laid out
+static void PrepareDraw(int iteration)
+{
+    NextFrame();
+    lastInputTime = frameTime = XPLMGetElapsedTime();
+    ShowHint(WATCH_KIND_HEADING, 123.0f);
+    UpdateHintTask(frameTime);
+}
+
+// show a new hint that still has to be formatted and laid out
+static void PrepareNewHint(int iteration)
+{
+    PrepareDraw(iteration);
+    ShowHint(iteration % HINT_KIND_COUNT, GetBenchValue(iteration));
+}
+
+static void RunDraw(int iteration)
+{
+    DrawCallback(xplm_Phase_LastCockpit, 0, NULL);
+}
+
+static void PrepareClick(int iteration)
+{
+    NextFrame();
+}
+
+static void RunClick(int iteration)
+{
+    HandleMouseClick(fakeWindow, 100, 100, xplm_MouseDown, NULL);
+}
+
+// let the read of the last command happen so the next one takes a new baseline
+static void PrepareCommand(int iteration)
+{
+    NextFrame();
+    commandWatchCount = 0;
+}
+
+static void RunCommand(int iteration)
+{
+    HandleCommand(commandBindings[0].command, xplm_CommandBegin, &commandBindings[0]);
+}
+
+static void PrepareFormat(int iteration)
+{
+    hintKind = iteration % HINT_KIND_COUNT;
+    hintValue = GetBenchValue(iteration);
+    hintFormatted = 0;
+}
+
+static void RunFormat(int iteration)
+{
+    FormatHint();
+}
+
+// the same texts formatted with snprintf, the formatter's reference
+static void RunSnprintf(int iteration)
+{
+    if (hintKind == WATCH_KIND_DRIFT)
+        sink += snprintf(benchText, sizeof(benchText), "%.1f deg", hintValue);
+    else if (hintKind == WATCH_KIND_HEADING)
+        sink += snprintf(benchText, sizeof(benchText), "%.0f deg", hintValue);
+    else
+        sink += snprintf(benchText, sizeof(benchText), "%.2f inHg / %.0f mb", hintValue, hintValue * INHG_TO_MB);
+}
+
+// run the diff kernel of the current set over keys of which every eighth one changed
+static void RunDiffKernel(int iteration)
+{
+    kernelSets[benchKernelSet].diff(kernelKeys, kernelLastKeys, KERNEL_ENTRIES, kernelMask);
+    sink += kernelMask[iteration % (KERNEL_ENTRIES / 32)];
+}
+
+// the wrap kernel works in place, so every operation starts over from the same readings
+static void PrepareWrapKernel(int iteration)
+{
+    memcpy(kernelValues, kernelInput, sizeof(kernelValues));
+}
+
+static void RunWrapKernel(int iteration)
+{
+    kernelSets[benchKernelSet].wrap(kernelValues, kernelMins, kernelRanges, KERNEL_ENTRIES);
+    sink += (int) kernelValues[iteration % KERNEL_ENTRIES];
+}
+
+static void PrepareNothing(int iteration)
+{
+}
+
+static void RunNothing(int iteration)
+{
+}
+
+// benchmarks in the order they are run
+static const Benchmark benchmarks[] =
+{
+    {"flight_loop_idle", PrepareFrame, RunFlightLoop},
+    {"flight_loop_polling", PreparePolling, RunFlightLoop},
+    {"flight_loop_change", PrepareChange, RunFlightLoop},
+    {"draw", PrepareDraw, RunDraw},
+    {"draw_new_hint", PrepareNewHint, RunDraw},
+    {"mouse_click", PrepareClick, RunClick},
+    {"command", PrepareCommand, RunCommand},
+    {"format_hint", PrepareFormat, RunFormat},
+    {"snprintf_hint", PrepareFormat, RunSnprintf}
+};
+
+// collect the kernel sets the CPU supports, the scalar one first, and fill the kernel inputs - half of the entries wrap into [0, 360) and half into [-180, 180), the readings lie up to two turns outside
+static void CollectKernelSets(void)
+{
+    KernelSet scalar = {"diff_scalar", "wrap_scalar", DiffScalar, WrapScalar};
+    kernelSets[kernelSetCount++] = scalar;
+
+#if defined(WATCH_SIMD) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+    {
+        KernelSet sse2 = {"diff_sse2", "wrap_sse2", DiffSse2, WrapSse2};
+        kernelSets[kernelSetCount++] = sse2;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        KernelSet avx2 = {"diff_avx2", "wrap_avx2", DiffAvx2, WrapAvx2};
+        kernelSets[kernelSetCount++] = avx2;
+    }
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        KernelSet avx512 = {"diff_avx512", "wrap_avx512", DiffAvx512, WrapAvx512};
+        kernelSets[kernelSetCount++] = avx512;
+    }
+#endif
+
+    for (int i = 0; i < KERNEL_ENTRIES; i++)
+    {
+        kernelKeys[i] = i;
+        kernelLastKeys[i] = i % 8 == 0 ? i + 1 : i;
+        kernelInput[i] = GetBenchValue(i * 7) * 2.0f - 360.0f;
+        kernelMins[i] = i % 2 == 0 ? 0.0f : -180.0f;
+        kernelRanges[i] = 360.0f;
+    }
+}
+
+// measure how many time stamp counter cycles pass per nanosecond - 0 if there is no counter, the wall time of every operation is measured then
+static void CalibrateCycleCounter(void)
+{
+    double start = GetWallTime();
+    unsigned long long startTicks = ReadCycleCounter();
+    while (GetWallTime() - start < 0.1)
+        ;
+    unsigned long long endTicks = ReadCycleCounter();
+
+    cyclesPerNanosecond = (double) (endTicks - startTicks) / ((GetWallTime() - start) * 1.0e9);
+}
+
+// measure an operation and return its cost per call - the counter converts cycles to nanoseconds, so both come from the same two reads around the call
+static void Measure(const Benchmark *benchmark, int cold, double *nanoseconds, double *cycles, double *allocationsPerOperation)
+{
+    int operations = cold != 0 ? COLD_OPERATIONS : WARM_OPERATIONS;
+    double wall = 0.0, ticks = 0.0;
+    unsigned long allocationCount = 0;
+
+    // warm caches and branch predictors first
+    for (int i = 0; i < 100; i++)
+    {
+        benchmark->prepare(i);
+        benchmark->run(i);
+    }
+
+    for (int i = 0; i < operations; i++)
+    {
+        benchmark->prepare(i);
+        if (cold != 0)
+            FlushCaches();
+
+        unsigned long mallocs = mallocCount;
+        double start = cyclesPerNanosecond > 0.0 ? 0.0 : GetWallTime();
+        unsigned long long startTicks = ReadCycleCounter();
+        benchmark->run(i);
+        unsigned long long endTicks = ReadCycleCounter();
+        double end = cyclesPerNanosecond > 0.0 ? 0.0 : GetWallTime();
+
+        allocationCount += mallocCount - mallocs;
+        wall += end - start;
+        ticks += (double) (endTicks - startTicks);
+    }
+
+    *cycles = ticks / operations;
+    *nanoseconds = cyclesPerNanosecond > 0.0 ? *cycles / cyclesPerNanosecond : wall / operations * 1.0e9;
+    *allocationsPerOperation = (double) allocationCount / operations;
+}
+
+// start the plugin with a config that watches the given number of elements of the benchmark array
+static int StartPlugin(const char *folder, int count)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/x_hint.cfg", folder);
+    FILE *config = fopen(path, "w");
+    if (config == NULL)
+        return 0;
+
+    // the governor reacts to wall time and would make the numbers depend on the previous benchmark
+    fprintf(config, "frame_budget 0\n");
+    for (int i = 0; i < count; i++)
+        fprintf(config, "watch " BENCH_DATAREF "[%d] heading\n", i);
+    fprintf(config, "command " BENCH_COMMAND " " BENCH_DATAREF "[0]\n");
+    fclose(config);
+
+    benchValues = MockAddDataRef(BENCH_DATAREF, xplmType_FloatArray, count);
+    MockAddCommand(BENCH_COMMAND);
+    benchWatchCount = count;
+
+    char name[256], signature[256], description[256];
+    if (XPluginStart(name, signature, description) == 0 || XPluginEnable() == 0)
+        return 0;
+    XPluginReceiveMessage(XPLM_NO_PLUGIN_ID, XPLM_MSG_PLANE_LOADED, NULL);
+
+    return watchCount == count;
+}
+
+// measure a benchmark with warm and cold caches and write one result line for each, the count is the number of watches or kernel entries it runs with - the cost of an empty operation is subtracted
+static void ReportBenchmark(const Benchmark *benchmark, int count, const double *emptyNanoseconds, const double *emptyCycles)
+{
+    for (int cold = 0; cold <= 1; cold++)
+    {
+        double nanoseconds = 0.0, cycles = 0.0, allocationsPerOperation = 0.0;
+        Measure(benchmark, cold, &nanoseconds, &cycles, &allocationsPerOperation);
+        nanoseconds = nanoseconds > emptyNanoseconds[cold] ? nanoseconds - emptyNanoseconds[cold] : 0.0;
+        cycles = cycles > emptyCycles[cold] ? cycles - emptyCycles[cold] : 0.0;
+
+        printf("bench: %-20s %5d watches %-4s %10.1f ns/op %10.1f cycles/op %6.2f allocs/op\n", benchmark->name, count, cold != 0 ? "cold" : "warm", nanoseconds, cycles, allocationsPerOperation);
+        fprintf(results, "%s,%s,%d,%s,%.1f,%.1f,%.3f,%d\n", VERSION, benchmark->name, count, cold != 0 ? "cold" : "warm", nanoseconds, cycles, allocationsPerOperation, cold != 0 ? COLD_OPERATIONS : WARM_OPERATIONS);
+    }
+}
+
+// run all benchmarks with warm and cold caches and write one result line for each - the cost of an empty operation, which is the overhead of the measurement, is subtracted
+static void RunBenchmarks(int count)
+{
+    double emptyNanoseconds[2], emptyCycles[2], emptyAllocations = 0.0;
+    Benchmark empty = {"empty", PrepareNothing, RunNothing};
+    for (int cold = 0; cold <= 1; cold++)
+        Measure(&empty, cold, &emptyNanoseconds[cold], &emptyCycles[cold], &emptyAllocations);
+
+    for (size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++)
+        ReportBenchmark(&benchmarks[b], count, emptyNanoseconds, emptyCycles);
+}
+
+// run the diff and wrap kernels of every supported set over the kernel entries with warm and cold caches and write one result line for each
+static void RunKernelBenchmarks(void)
+{
+    double emptyNanoseconds[2], emptyCycles[2], emptyAllocations = 0.0;
+    Benchmark empty = {"empty", PrepareNothing, RunNothing};
+    for (int cold = 0; cold <= 1; cold++)
+        Measure(&empty, cold, &emptyNanoseconds[cold], &emptyCycles[cold], &emptyAllocations);
+
+    for (benchKernelSet = 0; benchKernelSet < kernelSetCount; benchKernelSet++)
+    {
+        Benchmark diff = {kernelSets[benchKernelSet].diffName, PrepareNothing, RunDiffKernel};
+        ReportBenchmark(&diff, KERNEL_ENTRIES, emptyNanoseconds, emptyCycles);
+        Benchmark wrap = {kernelSets[benchKernelSet].wrapName, PrepareWrapKernel, RunWrapKernel};
+        ReportBenchmark(&wrap, KERNEL_ENTRIES, emptyNanoseconds, emptyCycles);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <results file> <work folder>\n", argv[0]);
+        return 2;
+    }
+
+    char path[1024];
+    mkdir(argv[2], 0755);
+    snprintf(path, sizeof(path), "%s/64/lin.xpl", argv[2]);
+    MockSetPluginPath(path);
+    snprintf(path, sizeof(path), "%s/", argv[2]);
+    MockSetSystemPath(path);
+
+    results = fopen(argv[1], "w");
+    if (results == NULL)
+    {
+        fprintf(stderr, "bench: could not write %s\n", argv[1]);
+        return 1;
+    }
+    fprintf(results, "version,benchmark,watches,cache,ns_per_op,cycles_per_op,allocations_per_op,operations\n");
+
+    CalibrateCycleCounter();
+    CollectKernelSets();
+    RunKernelBenchmarks();
+
+    // the built-in table size and a table of a heavily customized cockpit
+    static const int counts[] = {18, 1024};
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        if (StartPlugin(argv[2], counts[i]) == 0)
+        {
+            fprintf(stderr, "bench: the plugin did not start with %d watches\n", counts[i]);
+            return 1;
+        }
+
+        RunBenchmarks(counts[i]);
+
+        XPluginDisable();
+        XPluginStop();
+    }
+
+    fclose(results);
+    printf("bench: results written to %s\n", argv[1]);
+
+    return 0;
+}
@@ -0,0 +1,574 @@
+/* Copyright (C) 2015  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// checks of the plugin's kernels and helpers against their references - the plugin source is compiled into this driver and runs against the stub XPLM functions of the mock host, usage: check
+
+#include "../x_hint.cpp"
+
+#include "xplm_mock.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// define the number of failures reported per check before the rest is only counted
+#define MAX_REPORTED_FAILURES 10
+
+// define the number of values the exhaustive checks hand to a kernel at once and the most threads they run on
+#define CHECK_BATCH 4096
+#define MAX_CHECK_THREADS 64
+
+// kernel set of one instruction set - only the sets the CPU supports are checked
+typedef struct
+{
+    const char *name;
+    DiffKernel diff;
+    WrapKernel wrap;
+} KernelSet;
+
+// slice of the float bit patterns one thread of an exhaustive check covers, with the bounds of the range the wrap check wraps into
+typedef struct
+{
+    unsigned long long first, last;
+    float min, range;
+} FloatSlice;
+
+// global driver variables
+static int checks = 0, failures = 0, reportedFailures = 0;
+static unsigned int randomState = 1;
+static KernelSet kernelSets[4];
+static int kernelSetCount = 0;
+static unsigned int checkStride = 1;
+static int checkThreads = 1;
+static volatile int checkFailed = 0;
+static pthread_mutex_t failMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// start a check - failures are reported until the limit is reached
+static void BeginCheck(const char *name)
+{
+    checks++;
+    reportedFailures = 0;
+    checkFailed = 0;
+    printf("check: %s\n", name);
+    fflush(stdout);
+}
+
+// report a failure of the current check - returns 0 so a check can give up after a failure
+static int Fail(const char *format, ...)
+{
+    pthread_mutex_lock(&failMutex);
+    checkFailed = 1;
+    if (reportedFailures++ == 0)
+        failures++;
+
+    if (reportedFailures <= MAX_REPORTED_FAILURES)
+    {
+        va_list arguments;
+        va_start(arguments, format);
+        fprintf(stderr, "check: ");
+        vfprintf(stderr, format, arguments);
+        fprintf(stderr, "\n");
+        va_end(arguments);
+    }
+    pthread_mutex_unlock(&failMutex);
+
+    return 0;
+}
+
+// return a pseudo-random number - the same sequence in every run
+static unsigned int NextRandom(void)
+{
+    randomState = randomState * 1103515245u + 12345u;
+    return randomState >> 1;
+}
+
+// collect the kernel sets the CPU supports, the scalar one first
+static void CollectKernelSets(void)
+{
+    KernelSet scalar = {"scalar", DiffScalar, WrapScalar};
+    kernelSets[kernelSetCount++] = scalar;
+
+#if defined(WATCH_SIMD) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+    {
+        KernelSet sse2 = {"SSE2", DiffSse2, WrapSse2};
+        kernelSets[kernelSetCount++] = sse2;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        KernelSet avx2 = {"AVX2", DiffAvx2, WrapAvx2};
+        kernelSets[kernelSetCount++] = avx2;
+    }
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        KernelSet avx512 = {"AVX-512", DiffAvx512, WrapAvx512};
+        kernelSets[kernelSetCount++] = avx512;
+    }
+#endif
+
+    for (int i = 0; i < kernelSetCount; i++)
+        printf("check: kernel set %s\n", kernelSets[i].name);
+}
+
+// run every vectorized diff kernel on the given keys and compare its mask with the scalar kernel's - the kernels must not touch the mask beyond the words of the given count
+static int CompareDiffKernels(const int *keys, const int *lastKeys, int count)
+{
+    unsigned int expected[65], actual[65];
+    int words = (count + 31) / 32;
+
+    DiffScalar(keys, lastKeys, count, expected);
+    for (int k = 1; k < kernelSetCount; k++)
+    {
+        memset(actual, 0xa5, sizeof(actual));
+        kernelSets[k].diff(keys, lastKeys, count, actual);
+
+        for (int w = 0; w < words; w++)
+        {
+            if (actual[w] != expected[w])
+                return Fail("%s diff kernel gives word %d = %08x instead of %08x for %d entries", kernelSets[k].name, w, actual[w], expected[w], count);
+        }
+        if (actual[words] != 0xa5a5a5a5u)
+            return Fail("%s diff kernel writes past the mask for %d entries", kernelSets[k].name, count);
+    }
+
+    return 1;
+}
+
+// the vectorized diff kernels must match the scalar kernel for every pattern of equal and differing keys in a 16-entry window at every lane offset, for every count and for unaligned arrays
+static void CheckDiffKernels(void)
+{
+    BeginCheck("diff kernels match the scalar kernel");
+
+    int keys[2048 + 16], lastKeys[2048 + 16];
+
+    // every change pattern of 16 consecutive entries, placed at each lane offset of a 32-entry word
+    for (int offset = 0; offset <= 16; offset += 4)
+    {
+        for (unsigned int pattern = 0; pattern < 0x10000; pattern++)
+        {
+            for (int i = 0; i < 64; i++)
+            {
+                keys[i] = (int) NextRandom() - (int) NextRandom();
+                lastKeys[i] = keys[i];
+            }
+            for (int i = 0; i < 16; i++)
+            {
+                if ((pattern & (1u << i)) != 0)
+                    lastKeys[offset + i] = keys[offset + i] ^ (1 << (NextRandom() % 32));
+            }
+
+            if (CompareDiffKernels(keys, lastKeys, 64) == 0)
+                return;
+        }
+    }
+
+    // every count up to 2048 with unaligned arrays and extreme keys
+    for (int count = 0; count <= 2048; count++)
+    {
+        int shift = count % 4, *k = keys + shift, *l = lastKeys + (3 - shift);
+        for (int i = 0; i < count; i++)
+        {
+            unsigned int r = NextRandom();
+            k[i] = r % 5 == 0 ? INT_MIN : (r % 5 == 1 ? INT_MAX : (int) NextRandom());
+            l[i] = r % 3 == 0 ? k[i] : (r % 7 == 0 ? ~k[i] : (int) NextRandom());
+        }
+
+        if (CompareDiffKernels(k, l, count) == 0)
+            return;
+    }
+}
+
+// return the distance from a float to the next larger one in magnitude
+static double GetUlp(float value)
+{
+    float magnitude = fabsf(value);
+    return (double) nextafterf(magnitude, INFINITY) - magnitude;
+}
+
+// check one batch of values against the double-precision reference and the wrap kernels against the scalar kernel - the result must lie in [min, min + range) and, on the circle, within a few units in the last place of the value and of the bounds from the exact remainder
+static int CompareWrapKernels(const float *values, int count, float min, float range)
+{
+    float mins[CHECK_BATCH], ranges[CHECK_BATCH], expected[CHECK_BATCH], actual[CHECK_BATCH];
+
+    for (int i = 0; i < count; i++)
+    {
+        mins[i] = min;
+        ranges[i] = range;
+    }
+
+    memcpy(expected, values, count * sizeof(float));
+    WrapScalar(expected, mins, ranges, count);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!(expected[i] >= min && expected[i] < min + range))
+            return Fail("wrapping %.9g into [%g, %g) gives %.9g", values[i], min, min + range, expected[i]);
+
+        // beyond a tolerance of half the range every result inside the range is as close as the float value allows
+        double tolerance = 4.0 * (GetUlp(values[i]) + GetUlp(fabsf(min) + range));
+        if (isfinite(values[i]) == 0 || tolerance >= 0.5 * range)
+            continue;
+
+        double remainder = fmod((double) values[i] - min, range);
+        if (remainder < 0.0)
+            remainder += range;
+        double distance = fabs(expected[i] - (min + remainder));
+        distance = distance < range - distance ? distance : range - distance;
+        if (distance > tolerance)
+            return Fail("wrapping %.9g into [%g, %g) gives %.9g instead of %.9g", values[i], min, min + range, expected[i], min + remainder);
+    }
+
+    for (int k = 1; k < kernelSetCount; k++)
+    {
+        memcpy(actual, values, count * sizeof(float));
+        kernelSets[k].wrap(actual, mins, ranges, count);
+
+        for (int i = 0; i < count; i++)
+        {
+            if (memcmp(&actual[i], &expected[i], sizeof(float)) != 0)
+                return Fail("%s wrap kernel wraps %.9g into [%g, %g) as %.9g instead of %.9g", kernelSets[k].name, values[i], min, min + range, actual[i], expected[i]);
+        }
+    }
+
+    return 1;
+}
+
+// split the float bit patterns into one slice per thread and run the given check on every slice - slices start at multiples of the stride so the threads together visit the same patterns one thread would
+static void RunSlices(void *(*checkSlice)(void*), float min, float range)
+{
+    unsigned long long patterns = 0x100000000ull, sliceLength = (patterns / checkThreads + checkStride - 1) / checkStride * checkStride;
+    FloatSlice slices[MAX_CHECK_THREADS];
+    pthread_t threads[MAX_CHECK_THREADS];
+    int started[MAX_CHECK_THREADS];
+
+    for (int t = 0; t < checkThreads; t++)
+    {
+        slices[t].first = t * sliceLength < patterns ? t * sliceLength : patterns;
+        slices[t].last = (t + 1) * sliceLength < patterns && t + 1 < checkThreads ? (t + 1) * sliceLength : patterns;
+        slices[t].min = min;
+        slices[t].range = range;
+        started[t] = t > 0 && pthread_create(&threads[t], NULL, checkSlice, &slices[t]) == 0;
+    }
+
+    // the first slice and any slice whose thread did not start run on the main thread
+    for (int t = 0; t < checkThreads; t++)
+    {
+        if (started[t] == 0)
+            checkSlice(&slices[t]);
+    }
+    for (int t = 1; t < checkThreads; t++)
+    {
+        if (started[t] != 0)
+            pthread_join(threads[t], NULL);
+    }
+}
+
+// wrap the float bit patterns of one slice and check them
+static void *CheckWrapSlice(void *argument)
+{
+    const FloatSlice *slice = (const FloatSlice*) argument;
+    float values[CHECK_BATCH];
+    int count = 0;
+
+    for (unsigned long long bits = slice->first; bits < slice->last && checkFailed == 0; bits += checkStride)
+    {
+        unsigned int pattern = (unsigned int) bits;
+        memcpy(&values[count++], &pattern, sizeof(float));
+
+        if (count == CHECK_BATCH || bits + checkStride >= slice->last)
+        {
+            CompareWrapKernels(values, count, slice->min, slice->range);
+            count = 0;
+        }
+    }
+
+    return NULL;
+}
+
+// every float wrapped into the given range must match the reference, and every wrap kernel must match the scalar kernel bit for bit
+static void CheckWrapKernels(float min, float range)
+{
+    char name[128];
+    snprintf(name, sizeof(name), "wrap kernels match the reference for [%g, %g)", min, min + range);
+    BeginCheck(name);
+
+    RunSlices(CheckWrapSlice, min, range);
+}
+
+// format the float bit patterns of one slice with 0 to 2 decimals and compare the text with printf's
+static void *CheckFormatSlice(void *argument)
+{
+    const FloatSlice *slice = (const FloatSlice*) argument;
+
+    for (unsigned long long bits = slice->first; bits < slice->last && checkFailed == 0; bits += checkStride)
+    {
+        unsigned int pattern = (unsigned int) bits;
+        float value;
+        memcpy(&value, &pattern, sizeof(float));
+
+        for (int decimals = 0; decimals <= 2; decimals++)
+        {
+            char expected[64], actual[64];
+            if (fabsf(value) < FORMAT_LIMIT)
+                snprintf(expected, sizeof(expected), "%.*f", decimals, value);
+            else
+                strcpy(expected, "---");
+            AppendFixed(actual, 0, sizeof(actual), value, decimals);
+
+            if (strcmp(actual, expected) != 0)
+            {
+                Fail("formatting %.9g (0x%08x) with %d decimals gives \"%s\" instead of \"%s\"", value, pattern, decimals, actual, expected);
+                break;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+// the fixed-point formatter must give printf's text for every float and the hint formatters the text of their printf formats - CHECK_STRIDE and CHECK_THREADS apply as for the wrap check
+static void CheckFormatter(void)
+{
+    BeginCheck("formatter matches printf");
+
+    RunSlices(CheckFormatSlice, 0.0f, 0.0f);
+
+    // the hint formatters only join the formatted values with their units
+    for (int i = 0; i < 100000; i++)
+    {
+        unsigned int pattern = NextRandom() * 2u + (i & 1);
+        float value;
+        memcpy(&value, &pattern, sizeof(float));
+        if (i % 2 == 0)
+            value = (float) (NextRandom() % 4000000) / 1000.0f - 2000.0f;
+
+        char expected[64];
+        hintKind = WATCH_KIND_DRIFT + i % 3;
+        hintValue = value;
+        hintFormatted = 0;
+        FormatHint();
+
+        float mb = value * INHG_TO_MB;
+        if (hintKind == WATCH_KIND_DRIFT)
+            snprintf(expected, sizeof(expected), fabsf(value) < FORMAT_LIMIT ? "%.1f deg" : "--- deg", value);
+        else if (hintKind == WATCH_KIND_HEADING)
+            snprintf(expected, sizeof(expected), fabsf(value) < FORMAT_LIMIT ? "%.0f deg" : "--- deg", value);
+        else if (fabsf(value) < FORMAT_LIMIT && fabsf(mb) < FORMAT_LIMIT)
+            snprintf(expected, sizeof(expected), "%.2f inHg / %.0f mb", value, mb);
+        else if (fabsf(value) < FORMAT_LIMIT)
+            snprintf(expected, sizeof(expected), "%.2f inHg / --- mb", value);
+        else
+            snprintf(expected, sizeof(expected), "--- inHg / --- mb");
+        expected[HINT_TEXT_LENGTH - 1] = '\0';
+
+        if (strcmp(hintText, expected) != 0 && Fail("hint of kind %d for %.9g is \"%s\" instead of \"%s\"", hintKind, value, hintText, expected) == 0)
+            return;
+    }
+}
+
+// write the values a hint of the given kind shows for a value
+static void FormatKindValues(char *text, int size, float value, int kind)
+{
+    int length = AppendFixed(text, 0, size, value, GetKindDecimals(kind));
+    if (kind == WATCH_KIND_BAROMETER)
+    {
+        length = AppendText(text, length, size, " / ");
+        AppendFixed(text, length, size, value * INHG_TO_MB, 0);
+    }
+}
+
+// walk the float bit patterns of one slice in order and require that the key of every kind changes from one float to the next exactly when the text of its hint does - CHECK_STRIDE skips all but every n-th run of CHECK_BATCH patterns
+static void *CheckKeySlice(void *argument)
+{
+    const FloatSlice *slice = (const FloatSlice*) argument;
+    char texts[3][64];
+    int keys[3], previous[3] = {0, 0, 0};
+
+    for (unsigned long long bits = slice->first; bits < slice->last && checkFailed == 0; bits++)
+    {
+        if (bits / CHECK_BATCH % checkStride != 0)
+        {
+            bits = (bits / CHECK_BATCH + 1) * CHECK_BATCH - 1;
+            previous[0] = previous[1] = previous[2] = 0;
+            continue;
+        }
+
+        // the float before 0x80000000 is the largest NaN, not -0
+        unsigned int pattern = (unsigned int) bits;
+        if (pattern == 0x80000000u)
+            previous[0] = previous[1] = previous[2] = 0;
+
+        float value;
+        memcpy(&value, &pattern, sizeof(float));
+
+        for (int kind = 0; kind < 3; kind++)
+        {
+            // beyond QUANTIZE_LIMIT units all values share one key although their text differs
+            if (fabsf(value) < FORMAT_LIMIT && RoundToUnits(value, GetKindDecimals(kind)) >= QUANTIZE_LIMIT)
+            {
+                previous[kind] = 0;
+                continue;
+            }
+
+            char text[64];
+            int key = QuantizeKey(value, kind, 1);
+            FormatKindValues(text, sizeof(text), value, kind);
+
+            if (previous[kind] != 0 && (key != keys[kind]) != (strcmp(text, texts[kind]) != 0))
+            {
+                Fail("the key of kind %d goes from %d to %d while the text goes from \"%s\" to \"%s\" at %.9g (0x%08x)", kind, keys[kind], key, texts[kind], text, value, pattern);
+                return NULL;
+            }
+
+            keys[kind] = key;
+            strcpy(texts[kind], text);
+            previous[kind] = 1;
+        }
+    }
+
+    return NULL;
+}
+
+// the key of a value must change between adjacent floats exactly when the formatted hint does, for every kind at its default quantum
+static void CheckQuantizeKeys(void)
+{
+    BeginCheck("keys change exactly when the hint text does");
+
+    RunSlices(CheckKeySlice, 0.0f, 0.0f);
+
+    // the walk covers both signs apart, they meet between -0 and 0
+    for (int kind = 0; kind < 3; kind++)
+    {
+        char negative[64], positive[64];
+        FormatKindValues(negative, sizeof(negative), -0.0f, kind);
+        FormatKindValues(positive, sizeof(positive), 0.0f, kind);
+        if ((QuantizeKey(-0.0f, kind, 1) != QuantizeKey(0.0f, kind, 1)) != (strcmp(negative, positive) != 0))
+            Fail("the keys of kind %d for -0 and 0 do not tell \"%s\" and \"%s\" apart", kind, negative, positive);
+    }
+
+    // default quanta are one formatted unit
+    if (GetQuantumSteps(WATCH_KIND_DRIFT, DRIFT_QUANTUM) != 1 || GetQuantumSteps(WATCH_KIND_HEADING, HEADING_QUANTUM) != 1 || GetQuantumSteps(WATCH_KIND_BAROMETER, BAROMETER_QUANTUM) != 1)
+        Fail("a default quantum spans more than one formatted unit");
+}
+
+// smoothing moves along the shorter way around a wrapped range, the smoothed value must land inside the range again
+static void CheckSmoothingWrap(void)
+{
+    BeginCheck("smoothed values stay inside their wrap range");
+
+    MockAddDataRef("x_hint/check/heading", xplmType_Float, 1);
+    int index = AddWatch("x_hint/check/heading", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    if (index < 0)
+    {
+        Fail("the heading watch was not added");
+        return;
+    }
+    watchSmoothing[index] = 0.5f;
+    watchFiltered[index] = 1;
+
+    // from 359.9 halfway to 0.1 is 360.0, which reads as 0
+    static const float values[][2] = {{359.9f, 0.1f}, {0.1f, 359.9f}, {359.0f, 1.0f}, {180.0f, 0.5f}};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        SetWatchBaseline(index, values[i][0]);
+        for (int step = 0; step < 100; step++)
+        {
+            float value = FilterValue(index, values[i][1]);
+            if (!(value >= 0.0f && value < 360.0f))
+            {
+                Fail("smoothing from %g towards %g gives %.9g at step %d", values[i][0], values[i][1], value, step);
+                break;
+            }
+        }
+    }
+
+    ClearWatches();
+}
+
+// an array index in a watched dataref name has to be a plain decimal number that closes the name, everything else is rejected before a dataref is looked up
+static void CheckWatchNames(void)
+{
+    BeginCheck("array indices in dataref names are validated");
+
+    MockAddDataRef("x_hint/check/array", xplmType_FloatArray, 8);
+    static const struct
+    {
+        const char *name;
+        int element;
+    } names[] = {{"x_hint/check/array", -1}, {"x_hint/check/array[3]", 3}, {"x_hint/check/array[0]", 0}, {"x_hint/check/array[]", -2}, {"x_hint/check/array[-1]", -2}, {"x_hint/check/array[+1]", -2}, {"x_hint/check/array[ 3]", -2}, {"x_hint/check/array[3x]", -2}, {"x_hint/check/array[3", -2}, {"x_hint/check/array[3]x", -2}, {"x_hint/check/array[99999999999]", -2}};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        int element = 0, isElement = 0;
+        XPLMDataRef dataRef = FindWatchDataRef(names[i].name, &element, &isElement);
+        if (names[i].element == -2 && dataRef != NULL)
+            Fail("%s is accepted", names[i].name);
+        else if (names[i].element != -2 && (dataRef == NULL || element != (names[i].element < 0 ? 0 : names[i].element) || isElement != (names[i].element >= 0)))
+            Fail("%s is not found as element %d", names[i].name, names[i].element);
+    }
+
+    // a well-formed name of a dataref that does not exist yet waits for a plane load, a malformed one never resolves
+    if (IsMissingDataRef("x_hint/check/late[2]") == 0 || IsMissingDataRef("x_hint/check/late[x]") != 0 || IsMissingDataRef("x_hint/check/array[2]") != 0)
+        Fail("missing datarefs are not told apart from malformed names");
+}
+
+// config lines that name a dataref the sim does not have yet are reported as pending and resolve once the dataref exists
+static void CheckPendingLines(void)
+{
+    BeginCheck("config lines resolve once their datarefs exist");
+
+    if (ParseDataRefLine("watch x_hint/check/pending heading\n") != 0 || ParseDataRefLine("filter x_hint/check/pending 0.5\n") != 0 || ParseDataRefLine("watch x_hint/check/pending[x] heading\n") == 0 || watchCount != 0)
+        Fail("lines of a missing dataref are not kept pending");
+
+    MockAddDataRef("x_hint/check/pending", xplmType_Float, 1);
+    if (ParseDataRefLine("watch x_hint/check/pending heading\n") == 0 || ParseDataRefLine("filter x_hint/check/pending 0.5\n") == 0 || watchCount != 1 || filterRuleCount != 1)
+        Fail("lines do not resolve once their dataref exists");
+
+    ClearWatches();
+    filterRuleCount = 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *stride = getenv("CHECK_STRIDE");
+    if (stride != NULL && atoi(stride) > 0)
+        checkStride = atoi(stride);
+    const char *threads = getenv("CHECK_THREADS");
+    checkThreads = threads != NULL ? atoi(threads) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    checkThreads = checkThreads < 1 ? 1 : (checkThreads > MAX_CHECK_THREADS ? MAX_CHECK_THREADS : checkThreads);
+
+    CollectKernelSets();
+
+    CheckDiffKernels();
+    CheckWrapKernels(0.0f, 360.0f);
+    CheckWrapKernels(-180.0f, 360.0f);
+    CheckWrapKernels(0.0f, 2.5f);
+    CheckWrapKernels(-0.3f, 0.7f);
+    CheckWrapKernels(1.0f, 6.28318531f);
+    CheckFormatter();
+    CheckQuantizeKeys();
+    CheckSmoothingWrap();
+    CheckWatchNames();
+    CheckPendingLines();
+
+    printf("check: %d of %d checks passed\n", checks - failures, checks);
+    return failures != 0;
+}
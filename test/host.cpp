@@ -0,0 +1,395 @@
+/* Copyright (C) 2015  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// driver that loads the plugin binary into the mock host, plays a scripted session of mouse, command and plane load events on the virtual clock and checks the hints it draws - with record the plugin records the session to the work folder, usage: host <plugin binary> <work folder> [record]
+
+#include "XPLMPlugin.h"
+
+#include "xplm_mock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// define the frame length of the virtual clock
+#define FRAME_TIME (1.0f / 60.0f)
+
+// define the frame budget the config gives the governor, the read time of a dataref that is too slow for it and the read time it recovers to, which is within the budget for one read but not for two
+#define FRAME_BUDGET 0.001
+#define SLOW_READ_DELAY 0.003
+#define RECOVERED_READ_DELAY 0.0006
+
+// check a condition and count it as failed if it does not hold
+#define CHECK(condition) Check((condition) != 0, #condition, __LINE__)
+
+// built-in watches of the plugin
+static const char *watchNames[] =
+{
+    "sim/cockpit/gyros/dg_drift_vac_deg",
+    "sim/cockpit/gyros/dg_drift_ele_deg",
+    "sim/cockpit/gyros/dg_drift_vac2_deg",
+    "sim/cockpit/gyros/dg_drift_ele2_deg",
+    "sim/cockpit2/autopilot/heading_dial_deg_mag_pilot",
+    "sim/cockpit2/autopilot/heading_dial_deg_mag_copilot",
+    "sim/cockpit2/gauges/actuators/barometer_setting_in_hg_pilot",
+    "sim/cockpit2/gauges/actuators/barometer_setting_in_hg_copilot",
+    "sim/cockpit2/radios/actuators/adf1_card_heading_deg_mag_pilot",
+    "sim/cockpit2/radios/actuators/adf2_card_heading_deg_mag_pilot",
+    "sim/cockpit2/radios/actuators/adf1_card_heading_deg_mag_copilot",
+    "sim/cockpit2/radios/actuators/adf2_card_heading_deg_mag_copilot",
+    "sim/cockpit2/radios/actuators/hsi_obs_deg_mag_pilot",
+    "sim/cockpit2/radios/actuators/hsi_obs_deg_mag_copilot",
+    "sim/cockpit2/radios/actuators/nav1_obs_deg_mag_pilot",
+    "sim/cockpit2/radios/actuators/nav2_obs_deg_mag_pilot",
+    "sim/cockpit2/radios/actuators/nav1_obs_deg_mag_copilot",
+    "sim/cockpit2/radios/actuators/nav2_obs_deg_mag_copilot"
+};
+
+// built-in command bindings of the plugin
+static const char *commandNames[] =
+{
+    "sim/autopilot/heading_up",
+    "sim/autopilot/heading_down",
+    "sim/instruments/barometer_up",
+    "sim/instruments/barometer_down",
+    "sim/radios/adf1_card_up",
+    "sim/radios/adf1_card_down",
+    "sim/radios/adf2_card_up",
+    "sim/radios/adf2_card_down",
+    "sim/radios/obs_HSI_up",
+    "sim/radios/obs_HSI_down",
+    "sim/radios/obs1_up",
+    "sim/radios/obs1_down",
+    "sim/radios/obs2_up",
+    "sim/radios/obs2_down"
+};
+
+// global driver variables
+static int checks = 0, failures = 0;
+static std::vector<double> frameTimes;
+
+// count a check and report it if it failed
+static void Check(int passed, const char *condition, int line)
+{
+    checks++;
+    if (passed == 0)
+    {
+        failures++;
+        fprintf(stderr, "host: check failed at line %d: %s (drawn text '%s', %.2f s)\n", line, condition, MockGetDrawnText(), MockGetTime());
+    }
+}
+
+// return the CPU time of the calling thread in seconds - unlike the wall time it does not grow while other processes run
+static double GetThreadTime(void)
+{
+    struct timespec thread;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &thread);
+    return thread.tv_sec + thread.tv_nsec * 1.0e-9;
+}
+
+// run frames on the virtual clock with a mouse click every given number of frames, which keeps the plugin polling, and return the CPU time of the slowest frame including its click
+static double RunClickedFrames(int count, int clickInterval)
+{
+    double worst = 0.0;
+    for (int i = 0; i < count; i++)
+    {
+        double start = GetThreadTime();
+        if (i % clickInterval == 0)
+            MockClick();
+        frameTimes.push_back(MockRunFrame(FRAME_TIME));
+        worst = std::max(worst, GetThreadTime() - start);
+    }
+
+    return worst;
+}
+
+// run frames on the virtual clock and return the number of hints that appeared in them - a hint appears when the drawn text changes to another one that is not empty
+static int RunCountingHints(int count)
+{
+    int hints = 0;
+    std::string previous = MockGetDrawnText();
+    for (int i = 0; i < count; i++)
+    {
+        frameTimes.push_back(MockRunFrame(FRAME_TIME));
+        const char *text = MockGetDrawnText();
+        if (text[0] != '\0' && previous != text)
+            hints++;
+        previous = text;
+    }
+
+    return hints;
+}
+
+// run frames on the virtual clock and keep their wall time
+static void RunFrames(int count)
+{
+    for (int i = 0; i < count; i++)
+        frameTimes.push_back(MockRunFrame(FRAME_TIME));
+}
+
+// run frames until the given text is drawn or the given number of frames passed - returns 1 if it was drawn
+static int RunUntilDrawn(const char *text, int maxFrames)
+{
+    for (int i = 0; i < maxFrames; i++)
+    {
+        RunFrames(1);
+        if (strcmp(MockGetDrawnText(), text) == 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+// return the given percentile of the collected frame times in nanoseconds
+static double GetFramePercentile(std::vector<double> times, double fraction)
+{
+    if (times.empty())
+        return 0.0;
+
+    std::sort(times.begin(), times.end());
+    return times[(size_t) (fraction * (times.size() - 1))] * 1.0e9;
+}
+
+// print the wall time statistics of the frames run since the last report
+static void ReportFrames(const char *phase)
+{
+    printf("host: %-16s %6zu frames, p50 %8.0f ns, p99 %8.0f ns, worst %8.0f ns\n", phase, frameTimes.size(), GetFramePercentile(frameTimes, 0.5), GetFramePercentile(frameTimes, 0.99), GetFramePercentile(frameTimes, 1.0));
+    frameTimes.clear();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3 && !(argc == 4 && strcmp(argv[3], "record") == 0))
+    {
+        fprintf(stderr, "usage: %s <plugin binary> <work folder> [record]\n", argv[0]);
+        return 2;
+    }
+
+    // the config watches a knob of an aircraft plugin that creates its dataref and command only when its plane is loaded, a flickering value behind a hysteresis, a debounced knob with a command and a dataref that becomes slow to read
+    char path[1024];
+    mkdir(argv[2], 0755);
+    snprintf(path, sizeof(path), "%s/x_hint.cfg", argv[2]);
+    FILE *config = fopen(path, "w");
+    if (config == NULL)
+        return 1;
+    fputs("watch x_hint/host/late_heading heading\ncommand x_hint/host/late_heading_up x_hint/host/late_heading\n", config);
+    fputs("watch x_hint/host/flicker heading\nfilter x_hint/host/flicker 1 0.5\n", config);
+    fputs("watch x_hint/host/debounced heading\nfilter x_hint/host/debounced 1 0 2\ncommand x_hint/host/debounced_up x_hint/host/debounced\n", config);
+    fprintf(config, "watch x_hint/host/slow heading\nframe_budget %.0f\n", FRAME_BUDGET * 1.0e6);
+    if (argc == 4)
+        fputs("record\n", config);
+    fclose(config);
+    snprintf(path, sizeof(path), "%s/64/lin.xpl", argv[2]);
+    MockSetPluginPath(path);
+    snprintf(path, sizeof(path), "%s/", argv[2]);
+    MockSetSystemPath(path);
+    MockSetVerbose(getenv("HOST_VERBOSE") != NULL);
+
+    XPLMDataRef watches[sizeof(watchNames) / sizeof(watchNames[0])];
+    for (size_t i = 0; i < sizeof(watchNames) / sizeof(watchNames[0]); i++)
+        watches[i] = MockAddDataRef(watchNames[i], xplmType_Float, 1);
+    for (size_t i = 0; i < sizeof(commandNames) / sizeof(commandNames[0]); i++)
+        MockAddCommand(commandNames[i]);
+    XPLMDataRef flicker = MockAddDataRef("x_hint/host/flicker", xplmType_Float, 1), debounced = MockAddDataRef("x_hint/host/debounced", xplmType_Float, 1);
+    XPLMCommandRef debouncedUp = MockAddCommand("x_hint/host/debounced_up");
+    XPLMDataRef slow = MockAddDataRef("x_hint/host/slow", xplmType_Float, 1);
+    XPLMDataRef drift = watches[0], headingPilot = watches[4], headingCopilot = watches[5], barometerPilot = watches[6], barometerCopilot = watches[7];
+    MockSetValue(barometerPilot, 0, 29.92f);
+    MockSetValue(barometerCopilot, 0, 29.92f);
+
+    if (MockLoadPlugin(argv[1]) == 0)
+        return 1;
+    MockSendMessage(XPLM_MSG_PLANE_LOADED);
+
+    // without input the plugin neither reads datarefs nor draws
+    RunFrames(600);
+    CHECK(MockGetReadCount() == 0);
+    CHECK(MockGetDrawCallbackCount() == 0);
+    ReportFrames("idle");
+
+    // a knob turned by mouse shows its new value until the hint expires
+    MockClick();
+    MockSetValue(headingPilot, 0, 370.0f);
+    MockSetValue(headingCopilot, 0, 370.0f);
+    CHECK(RunUntilDrawn("10 deg", 30));
+    int hintOffsetX = 0, hintOffsetY = 0;
+    MockGetDrawnPosition(&hintOffsetX, &hintOffsetY);
+    hintOffsetX -= 100;
+    hintOffsetY -= 100;
+    RunFrames(300);
+    CHECK(MockGetDrawCallbackCount() == 0);
+    CHECK(strcmp(MockGetDrawnText(), "") == 0);
+
+    // barometer hints show inches of mercury and millibars
+    MockClick();
+    MockSetValue(barometerPilot, 0, 29.93f);
+    MockSetValue(barometerCopilot, 0, 29.93f);
+    CHECK(RunUntilDrawn("29.93 inHg / 1014 mb", 30));
+
+    // drifts are wrapped into [-180, 180)
+    MockWheel(1);
+    MockSetValue(drift, 0, -190.3f);
+    CHECK(RunUntilDrawn("169.7 deg", 30));
+    ReportFrames("burst");
+
+    // the scan latency is published next to the probe statistics
+    XPLMDataRef scanLatency = XPLMFindDataRef("x_hint/perf/worst_scan_latency_ns");
+    CHECK(scanLatency != NULL && XPLMGetDataf(scanLatency) >= 0.0f);
+
+    // polling stops once the burst is over
+    RunFrames(300);
+    MockResetReadCount();
+    RunFrames(300);
+    CHECK(MockGetReadCount() == 0);
+    CHECK(MockGetDrawCallbackCount() == 0);
+
+    // a bound command produces a hint without any mouse input
+    MockFireCommand(XPLMFindCommand("sim/autopilot/heading_up"), xplm_CommandBegin);
+    MockSetValue(headingPilot, 0, 11.0f);
+    MockSetValue(headingCopilot, 0, 11.0f);
+    CHECK(RunUntilDrawn("11 deg", 5));
+    MockFireCommand(XPLMFindCommand("sim/autopilot/heading_up"), xplm_CommandEnd);
+    RunFrames(300);
+
+    // pilot and copilot knobs that move together become aliases, a copilot knob that moves on its own still shows its hint
+    for (int i = 1; i <= 5; i++)
+    {
+        MockClick();
+        MockSetValue(headingPilot, 0, 10.0f * i);
+        MockSetValue(headingCopilot, 0, 10.0f * i);
+        char text[32];
+        sprintf(text, "%d deg", 10 * i);
+        CHECK(RunUntilDrawn(text, 30));
+        RunFrames(120);
+    }
+    MockClick();
+    MockSetValue(headingCopilot, 0, 123.0f);
+    CHECK(RunUntilDrawn("123 deg", 120));
+    RunFrames(300);
+
+    // the QPAC A320 suppresses heading hints but not barometer hints
+    MockSetPluginEnabled("QPAC.airbus.fbw", 1);
+    MockSendMessage(XPLM_MSG_PLANE_LOADED);
+    MockClick();
+    MockSetValue(headingPilot, 0, 77.0f);
+    MockSetValue(headingCopilot, 0, 77.0f);
+    CHECK(RunUntilDrawn("77 deg", 60) == 0);
+    MockClick();
+    MockSetValue(barometerPilot, 0, 30.01f);
+    MockSetValue(barometerCopilot, 0, 30.01f);
+    CHECK(RunUntilDrawn("30.01 inHg / 1016 mb", 60));
+    MockSetPluginEnabled("QPAC.airbus.fbw", 0);
+    MockSendMessage(XPLM_MSG_PLANE_LOADED);
+    RunFrames(300);
+    ReportFrames("session");
+
+    // the fake window takes the front back if another window took it
+    MockLoseFront();
+    RunFrames(120);
+    MockClick();
+    MockSetValue(headingPilot, 0, 200.0f);
+    MockSetValue(headingCopilot, 0, 200.0f);
+    CHECK(RunUntilDrawn("200 deg", 30));
+    RunFrames(300);
+
+    // the fake window follows a resized screen within its check interval of a second, so clicks in the new area are seen and the hint stays next to the mouse
+    MockSetScreenSize(2560, 1440);
+    MockSetMouseLocation(2400, 1300);
+    RunFrames(61);
+    MockClick();
+    MockSetValue(headingPilot, 0, 210.0f);
+    MockSetValue(headingCopilot, 0, 210.0f);
+    CHECK(RunUntilDrawn("210 deg", 30));
+    int hintX = 0, hintY = 0;
+    MockGetDrawnPosition(&hintX, &hintY);
+    CHECK(hintX == 2400 + hintOffsetX && hintY == 1300 + hintOffsetY);
+    CHECK(hintX >= 0 && hintX < 2560 && hintY >= 0 && hintY < 1440);
+    RunFrames(300);
+
+    // the knob of the aircraft plugin is watched and bound once its plane is loaded
+    XPLMDataRef lateHeading = MockAddDataRef("x_hint/host/late_heading", xplmType_Float, 1);
+    XPLMCommandRef lateHeadingUp = MockAddCommand("x_hint/host/late_heading_up");
+    MockSendMessage(XPLM_MSG_PLANE_LOADED);
+    MockFireCommand(lateHeadingUp, xplm_CommandBegin);
+    MockSetValue(lateHeading, 0, 42.0f);
+    CHECK(RunUntilDrawn("42 deg", 5));
+    MockFireCommand(lateHeadingUp, xplm_CommandEnd);
+    RunFrames(300);
+
+    // a value that flickers across the rounding step of its hint stays within the hysteresis and does not bring up a hint, a real move does
+    MockSetValue(flicker, 0, 10.4f);
+    MockClick();
+    RunFrames(30);
+    int hints = 0;
+    for (int i = 0; i < 120; i++)
+    {
+        if (i % 10 == 0)
+            MockClick();
+        MockSetValue(flicker, 0, i / 7 % 2 == 0 ? 10.6f : 10.4f);
+        hints += RunCountingHints(1);
+    }
+    CHECK(hints == 0);
+    MockClick();
+    MockSetValue(flicker, 0, 20.0f);
+    CHECK(RunUntilDrawn("20 deg", 30));
+    RunFrames(300);
+
+    // a burst of command repeats that turns a debounced knob in every frame shows a single hint with the value the knob settled on
+    hints = 0;
+    MockFireCommand(debouncedUp, xplm_CommandBegin);
+    for (int i = 1; i <= 20; i++)
+    {
+        MockSetValue(debounced, 0, (float) i);
+        hints += RunCountingHints(1);
+        MockFireCommand(debouncedUp, xplm_CommandContinue);
+    }
+    MockFireCommand(debouncedUp, xplm_CommandEnd);
+    hints += RunCountingHints(60);
+    CHECK(hints == 1);
+    CHECK(strcmp(MockGetDrawnText(), "20 deg") == 0);
+    RunFrames(300);
+
+    // a dataref that got slow to read makes the governor step down until it drops the watch - it judges single frames, so no frame takes longer than the budget plus one read
+    RunClickedFrames(30, 10);
+    MockClearLog();
+    MockSetReadDelay(slow, SLOW_READ_DELAY);
+    double worst = RunClickedFrames(360, 10);
+    CHECK(MockLogContains("governor full operation -> reduced poll rate"));
+    CHECK(MockLogContains("governor reduced poll rate -> expensive watches dropped"));
+    CHECK(MockLogContains("governor dropped watch"));
+    CHECK(worst <= FRAME_BUDGET + SLOW_READ_DELAY);
+
+    // once it is fast enough again the governor recovers and the scan takes the watch back in without a frame over the budget
+    MockClearLog();
+    MockSetReadDelay(slow, RECOVERED_READ_DELAY);
+    worst = RunClickedFrames(600, 10);
+    CHECK(MockLogContains("governor restored dropped watches"));
+    CHECK(worst <= FRAME_BUDGET);
+    MockSetReadDelay(slow, 0.0);
+    ReportFrames("governor");
+
+    CHECK(MockUnloadPlugin() == 0);
+
+    printf("host: %d of %d checks passed\n", checks - failures, checks);
+    return failures != 0;
+}
@@ -0,0 +1,562 @@
+/* Copyright (C) 2015  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// driver that feeds a recorded session through the plugin binary in the mock host - it rebuilds the watch table from the session's watch, command and filter records, replays every event at its frame time with the raw values the plugin read while handling it, diffs the hints against the recorded ones and reports the plugin's wall time per frame - usage: replay <plugin binary> <session file> <work folder>
+
+#include "XPLMPlugin.h"
+
+#include "xplm_mock.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+// session file format - must match the recording code of the plugin
+#define SESSION_MAGIC "XHINTREC"
+#define SESSION_VERSION 4
+
+// hint kinds in the order of the plugin's kind numbers
+static const char *kindNames[] = {"drift", "heading", "barometer"};
+#define KIND_COUNT ((int) (sizeof(kindNames) / sizeof(kindNames[0])))
+
+// signature of the stand-in plugin that suppresses a hint kind during the replay
+#define SUPPRESSOR_SIGNATURE "x_hint.replay."
+
+// watch table entry as described by a watch record
+typedef struct
+{
+    std::string name;
+    int kind, type, debounce, aliasPrimary;
+    float quantum, wrapMin, wrapRange, smoothing, hysteresis;
+    XPLMDataRef dataRef;
+    int element;
+} SessionWatch;
+
+// command binding as described by a command record
+typedef struct
+{
+    std::string name;
+    int watchIndex;
+} SessionCommand;
+
+// event, value, suppression or hint record
+typedef struct
+{
+    char type;
+    float time;
+    int arguments[4];
+    float value;
+    std::string text;
+} SessionRecord;
+
+// parsed session file
+typedef struct
+{
+    std::vector<SessionWatch> watches;
+    std::vector<SessionCommand> commands;
+    std::vector<SessionRecord> records;
+} Session;
+
+// return the wall time in seconds
+static double GetWallTime(void)
+{
+    struct timespec wall;
+    clock_gettime(CLOCK_MONOTONIC, &wall);
+    return wall.tv_sec + wall.tv_nsec * 1.0e-9;
+}
+
+// cursor over the bytes of a session file
+typedef struct
+{
+    const std::vector<unsigned char> *bytes;
+    size_t position;
+    int failed;
+} SessionReader;
+
+// copy the next bytes of the session into the given buffer - marks the reader as failed at the end of the file
+static void Read(SessionReader *reader, void *data, size_t size)
+{
+    if (reader->failed != 0 || reader->position + size > reader->bytes->size())
+    {
+        reader->failed = 1;
+        memset(data, 0, size);
+        return;
+    }
+
+    memcpy(data, &(*reader->bytes)[reader->position], size);
+    reader->position += size;
+}
+
+// read a string that is preceded by its length of the given size
+static std::string ReadString(SessionReader *reader, size_t lengthSize)
+{
+    unsigned short length = 0;
+    if (lengthSize == 1)
+    {
+        unsigned char shortLength = 0;
+        Read(reader, &shortLength, sizeof(shortLength));
+        length = shortLength;
+    }
+    else
+        Read(reader, &length, sizeof(length));
+
+    std::string text(length, '\0');
+    if (length != 0)
+        Read(reader, &text[0], length);
+
+    return text;
+}
+
+// return 1 if a record type is an event the replay dispatches to the plugin
+static int IsEvent(char type)
+{
+    return type != '\0' && strchr("FCSKLU", type) != NULL;
+}
+
+// parse a session file - returns 0 and prints why if it is not a session of the supported version
+static int LoadSession(const char *path, Session *session)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "replay: could not open %s\n", path);
+        return 0;
+    }
+
+    std::vector<unsigned char> bytes;
+    unsigned char buffer[65536];
+    size_t size = 0;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) != 0)
+        bytes.insert(bytes.end(), buffer, buffer + size);
+    fclose(file);
+
+    SessionReader reader = {&bytes, 0, 0};
+    char magic[sizeof(SESSION_MAGIC) - 1];
+    int version = 0;
+    Read(&reader, magic, sizeof(magic));
+    Read(&reader, &version, sizeof(version));
+    if (reader.failed != 0 || memcmp(magic, SESSION_MAGIC, sizeof(magic)) != 0 || version != SESSION_VERSION)
+    {
+        fprintf(stderr, "replay: %s is not a version %d session file\n", path, SESSION_VERSION);
+        return 0;
+    }
+
+    while (reader.position < bytes.size() && reader.failed == 0)
+    {
+        char type = 0;
+        Read(&reader, &type, sizeof(type));
+
+        if (type == 'W')
+        {
+            SessionWatch watch;
+            unsigned char kind = 0;
+            watch.name = ReadString(&reader, 2);
+            Read(&reader, &kind, sizeof(kind));
+            Read(&reader, &watch.type, sizeof(watch.type));
+            Read(&reader, &watch.quantum, sizeof(watch.quantum));
+            Read(&reader, &watch.wrapMin, sizeof(watch.wrapMin));
+            Read(&reader, &watch.wrapRange, sizeof(watch.wrapRange));
+            Read(&reader, &watch.smoothing, sizeof(watch.smoothing));
+            Read(&reader, &watch.hysteresis, sizeof(watch.hysteresis));
+            Read(&reader, &watch.debounce, sizeof(watch.debounce));
+            Read(&reader, &watch.aliasPrimary, sizeof(watch.aliasPrimary));
+            watch.kind = kind;
+            watch.dataRef = NULL;
+            watch.element = 0;
+            session->watches.push_back(watch);
+            continue;
+        }
+
+        if (type == 'M')
+        {
+            SessionCommand command;
+            unsigned int index = 0;
+            command.name = ReadString(&reader, 2);
+            Read(&reader, &index, sizeof(index));
+            command.watchIndex = (int) index;
+            session->commands.push_back(command);
+            continue;
+        }
+
+        // a plane load gave an entry new noise filters - the replay's datarefs all exist from the start, so its config applies them from the start as well
+        if (type == 'R')
+        {
+            unsigned int index = 0;
+            SessionWatch filter;
+            Read(&reader, &index, sizeof(index));
+            Read(&reader, &filter.smoothing, sizeof(filter.smoothing));
+            Read(&reader, &filter.hysteresis, sizeof(filter.hysteresis));
+            Read(&reader, &filter.debounce, sizeof(filter.debounce));
+            if (index < session->watches.size())
+            {
+                session->watches[index].smoothing = filter.smoothing;
+                session->watches[index].hysteresis = filter.hysteresis;
+                session->watches[index].debounce = filter.debounce;
+            }
+            continue;
+        }
+
+        SessionRecord record;
+        record.type = type;
+        record.time = 0.0f;
+        record.value = 0.0f;
+        memset(record.arguments, 0, sizeof(record.arguments));
+
+        if (type == 'V')
+        {
+            unsigned int index = 0;
+            Read(&reader, &index, sizeof(index));
+            Read(&reader, &record.value, sizeof(record.value));
+            record.arguments[0] = (int) index;
+        }
+        else if (type == 'Q')
+            Read(&reader, &record.arguments[0], sizeof(int));
+        else if (IsEvent(type) != 0 || type == 'H')
+        {
+            Read(&reader, &record.time, sizeof(record.time));
+            if (type == 'C' || type == 'S')
+                Read(&reader, record.arguments, 4 * sizeof(int));
+            else if (type == 'K')
+                Read(&reader, record.arguments, 2 * sizeof(int));
+            else if (type == 'H')
+                record.text = ReadString(&reader, 1);
+        }
+        else
+        {
+            fprintf(stderr, "replay: unknown record type '%c' at offset %zu of %s\n", type, reader.position - 1, path);
+            return 0;
+        }
+
+        session->records.push_back(record);
+    }
+
+    if (reader.failed != 0)
+        fprintf(stderr, "replay: %s ends in the middle of a record, the rest is ignored\n", path);
+
+    return 1;
+}
+
+// create the datarefs and commands of a session in the mock host - array datarefs get as many elements as the highest watched element needs, and as the screen size is not recorded the screen is made large enough for every recorded mouse event to land in the fake window
+static void CreateSessionObjects(Session *session)
+{
+    int screenWidth = 1920, screenHeight = 1080;
+    for (size_t i = 0; i < session->records.size(); i++)
+    {
+        const SessionRecord *record = &session->records[i];
+        if (record->type == 'C' || record->type == 'S')
+        {
+            screenWidth = std::max(screenWidth, record->arguments[0] + 1);
+            screenHeight = std::max(screenHeight, record->arguments[1] + 1);
+        }
+    }
+    MockSetScreenSize(screenWidth, screenHeight);
+
+    std::map<std::string, int> sizes, types;
+    for (size_t i = 0; i < session->watches.size(); i++)
+    {
+        SessionWatch *watch = &session->watches[i];
+        std::string base = watch->name;
+        size_t bracket = base.find('[');
+        if (bracket != std::string::npos)
+        {
+            watch->element = atoi(base.c_str() + bracket + 1);
+            base.erase(bracket);
+        }
+
+        types[base] = watch->type;
+        sizes[base] = std::max(sizes[base], watch->element + 1);
+    }
+
+    std::map<std::string, XPLMDataRef> dataRefs;
+    for (std::map<std::string, int>::iterator it = types.begin(); it != types.end(); ++it)
+        dataRefs[it->first] = MockAddDataRef(it->first.c_str(), it->second, sizes[it->first]);
+
+    for (size_t i = 0; i < session->watches.size(); i++)
+    {
+        std::string base = session->watches[i].name.substr(0, session->watches[i].name.find('['));
+        session->watches[i].dataRef = dataRefs[base];
+    }
+
+    for (size_t i = 0; i < session->commands.size(); i++)
+        MockAddCommand(session->commands[i].name.c_str());
+}
+
+// write a config file that rebuilds the recorded watch table, makes the plugin record the replay and turns off everything that depends on wall time
+static int WriteReplayConfig(const char *path, const Session *session)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "replay: could not write %s\n", path);
+        return 0;
+    }
+
+    fprintf(file, "record\nframe_budget 0\nscan_budget 1000000\n");
+    for (int kind = 0; kind < KIND_COUNT; kind++)
+        fprintf(file, "suppress " SUPPRESSOR_SIGNATURE "%s %s\n", kindNames[kind], kindNames[kind]);
+
+    for (size_t i = 0; i < session->watches.size(); i++)
+    {
+        const SessionWatch *watch = &session->watches[i];
+        fprintf(file, "watch %s %s %.9g %.9g %.9g\n", watch->name.c_str(), kindNames[watch->kind], watch->quantum, watch->wrapMin, watch->wrapMin + watch->wrapRange);
+        if (watch->smoothing < 1.0f || watch->hysteresis > 0.0f || watch->debounce > 0)
+            fprintf(file, "filter %s %.9g %.9g %d\n", watch->name.c_str(), watch->smoothing, watch->hysteresis, watch->debounce);
+    }
+
+    for (size_t i = 0; i < session->commands.size(); i++)
+        fprintf(file, "command %s %s\n", session->commands[i].name.c_str(), session->watches[session->commands[i].watchIndex].name.c_str());
+
+    fclose(file);
+    return 1;
+}
+
+// remove the session files a previous replay left in the work folder and return the path of the only one left after this replay
+static std::string CollectReplaySession(const char *folder, int remove)
+{
+    std::string path;
+    DIR *directory = opendir(folder);
+    if (directory == NULL)
+        return path;
+
+    for (struct dirent *entry = readdir(directory); entry != NULL; entry = readdir(directory))
+    {
+        size_t length = strlen(entry->d_name);
+        if (length < 4 || strcmp(entry->d_name + length - 4, ".rec") != 0)
+            continue;
+
+        path = std::string(folder) + "/" + entry->d_name;
+        if (remove != 0)
+            ::remove(path.c_str());
+    }
+    closedir(directory);
+
+    return remove != 0 ? std::string() : path;
+}
+
+// apply a value or suppression record to the mock host
+static void ApplyState(const Session *session, const SessionRecord *record)
+{
+    if (record->type == 'V' && record->arguments[0] < (int) session->watches.size())
+    {
+        const SessionWatch *watch = &session->watches[record->arguments[0]];
+        MockSetValue(watch->dataRef, watch->element, record->value);
+    }
+    else if (record->type == 'Q')
+    {
+        for (int kind = 0; kind < KIND_COUNT; kind++)
+            MockSetPluginEnabled((std::string(SUPPRESSOR_SIGNATURE) + kindNames[kind]).c_str(), (record->arguments[0] & (1 << kind)) != 0);
+    }
+}
+
+// return 1 if two watch records describe the same entry
+static int WatchesEqual(const SessionWatch *a, const SessionWatch *b)
+{
+    return a->name == b->name && a->kind == b->kind && a->type == b->type && a->quantum == b->quantum && a->wrapMin == b->wrapMin && a->wrapRange == b->wrapRange && a->smoothing == b->smoothing && a->hysteresis == b->hysteresis && a->debounce == b->debounce && a->aliasPrimary == b->aliasPrimary;
+}
+
+// return the given percentile of the frame times in nanoseconds
+static double GetFramePercentile(std::vector<double> times, double fraction)
+{
+    if (times.empty())
+        return 0.0;
+
+    std::sort(times.begin(), times.end());
+    return times[(size_t) (fraction * (times.size() - 1))] * 1.0e9;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "usage: %s <plugin binary> <session file> <work folder>\n", argv[0]);
+        return 2;
+    }
+
+    Session original;
+    if (LoadSession(argv[2], &original) == 0)
+        return 1;
+    if (original.watches.empty())
+    {
+        fprintf(stderr, "replay: %s holds no watch records\n", argv[2]);
+        return 1;
+    }
+
+    char path[1024];
+    mkdir(argv[3], 0755);
+    CollectReplaySession(argv[3], 1);
+    snprintf(path, sizeof(path), "%s/x_hint.cfg", argv[3]);
+    if (WriteReplayConfig(path, &original) == 0)
+        return 1;
+    snprintf(path, sizeof(path), "%s/64/lin.xpl", argv[3]);
+    MockSetPluginPath(path);
+    snprintf(path, sizeof(path), "%s/", argv[3]);
+    MockSetSystemPath(path);
+    MockSetVerbose(getenv("REPLAY_VERBOSE") != NULL);
+
+    CreateSessionObjects(&original);
+    for (size_t i = 0; i < original.commands.size(); i++)
+    {
+        if (original.commands[i].watchIndex >= (int) original.watches.size())
+        {
+            fprintf(stderr, "replay: command %s reads watch %d that has no watch record\n", original.commands[i].name.c_str(), original.commands[i].watchIndex);
+            return 1;
+        }
+    }
+
+    // the state the plugin saw while it started comes before the first event
+    size_t first = 0;
+    while (first < original.records.size() && IsEvent(original.records[first].type) == 0)
+        ApplyState(&original, &original.records[first++]);
+
+    if (MockLoadPlugin(argv[1]) == 0)
+        return 1;
+
+    std::vector<double> frameTimes;
+    double frameTime = 0.0;
+    int frameOpen = 0;
+    unsigned long events = 0;
+
+    for (size_t r = first; r < original.records.size(); r++)
+    {
+        const SessionRecord *record = &original.records[r];
+        if (IsEvent(record->type) == 0)
+            continue;
+
+        // events of a later frame end the current one with its draw callbacks
+        if (record->time > MockGetTime())
+        {
+            if (frameOpen != 0)
+                frameTimes.push_back(frameTime + MockRunDrawCallbacks());
+            MockBeginFrame(record->time);
+            frameTime = 0.0;
+            frameOpen = 1;
+        }
+
+        // the values and suppressions recorded after an event are what the plugin read while handling it
+        for (size_t s = r + 1; s < original.records.size() && IsEvent(original.records[s].type) == 0; s++)
+            ApplyState(&original, &original.records[s]);
+
+        events++;
+        double start = GetWallTime();
+        switch (record->type)
+        {
+        case 'F':
+            MockRunFlightLoops();
+            break;
+        case 'C':
+        case 'S':
+        {
+            MockSetMouseLocation(record->arguments[0], record->arguments[1]);
+            if (record->type == 'C')
+                MockClick();
+            else
+                MockWheel(record->arguments[3]);
+            break;
+        }
+        case 'K':
+        {
+            XPLMCommandRef command = NULL;
+            for (size_t i = 0; i < original.commands.size() && command == NULL; i++)
+            {
+                if (original.commands[i].watchIndex == record->arguments[0])
+                    command = XPLMFindCommand(original.commands[i].name.c_str());
+            }
+            if (command != NULL)
+                MockFireCommand(command, record->arguments[1]);
+            else
+                fprintf(stderr, "replay: no command reads watch %d at %.3f s\n", record->arguments[0], record->time);
+            break;
+        }
+        case 'L':
+            MockSendMessage(XPLM_MSG_PLANE_LOADED);
+            break;
+        case 'U':
+            MockSendMessage(XPLM_MSG_PLANE_UNLOADED);
+            break;
+        }
+        frameTime += GetWallTime() - start;
+    }
+    if (frameOpen != 0)
+        frameTimes.push_back(frameTime + MockRunDrawCallbacks());
+
+    int leaks = MockUnloadPlugin();
+
+    Session replayed;
+    std::string replayPath = CollectReplaySession(argv[3], 0);
+    if (replayPath.empty() || LoadSession(replayPath.c_str(), &replayed) == 0)
+    {
+        fprintf(stderr, "replay: the plugin did not record the replay\n");
+        return 1;
+    }
+
+    int failures = leaks != 0;
+    if (leaks != 0)
+        fprintf(stderr, "replay: the plugin left %d registrations behind\n", leaks);
+
+    // the replay has to rebuild the recorded watch table entry by entry
+    for (size_t i = 0; i < std::max(original.watches.size(), replayed.watches.size()); i++)
+    {
+        if (i >= original.watches.size() || i >= replayed.watches.size() || WatchesEqual(&original.watches[i], &replayed.watches[i]) == 0)
+        {
+            fprintf(stderr, "replay: watch %zu differs from the recorded one (%s)\n", i, i < original.watches.size() ? original.watches[i].name.c_str() : replayed.watches[i].name.c_str());
+            failures++;
+            break;
+        }
+    }
+
+    // diff the hint sequences
+    std::vector<const SessionRecord*> expected, actual;
+    for (size_t i = 0; i < original.records.size(); i++)
+    {
+        if (original.records[i].type == 'H')
+            expected.push_back(&original.records[i]);
+    }
+    for (size_t i = 0; i < replayed.records.size(); i++)
+    {
+        if (replayed.records[i].type == 'H')
+            actual.push_back(&replayed.records[i]);
+    }
+
+    int mismatches = 0;
+    for (size_t i = 0; i < std::max(expected.size(), actual.size()); i++)
+    {
+        const SessionRecord *a = i < expected.size() ? expected[i] : NULL, *b = i < actual.size() ? actual[i] : NULL;
+        if (a != NULL && b != NULL && a->text == b->text)
+            continue;
+
+        if (mismatches++ < 10)
+            fprintf(stderr, "replay: hint %zu recorded '%s' at %.3f s, replayed '%s' at %.3f s\n", i, a != NULL ? a->text.c_str() : "", a != NULL ? a->time : 0.0f, b != NULL ? b->text.c_str() : "", b != NULL ? b->time : 0.0f);
+    }
+    failures += mismatches != 0;
+
+    double total = 0.0;
+    for (size_t i = 0; i < frameTimes.size(); i++)
+        total += frameTimes[i];
+
+    printf("replay: %lu events in %zu frames, %zu of %zu hints match\n", events, frameTimes.size(), std::max(expected.size(), actual.size()) - mismatches, expected.size());
+    printf("replay: mean %8.0f ns/frame, p50 %8.0f ns, p99 %8.0f ns, worst %8.0f ns\n", frameTimes.empty() ? 0.0 : total / frameTimes.size() * 1.0e9, GetFramePercentile(frameTimes, 0.5), GetFramePercentile(frameTimes, 0.99), GetFramePercentile(frameTimes, 1.0));
+
+    return failures != 0;
+}
@@ -0,0 +1,228 @@
+/* Copyright (C) 2015  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// load test that runs the plugin binary in the mock host against 1k, 10k and 50k watched float, int and array datarefs - a scripted minute of flying with idle phases, knob turns, instruments that move on their own and a plane load is played for every table size, the plugin's wall time per frame including its input handlers is reported as p50/p99/p99.9 and the test fails if the p99.9 exceeds the budget, usage: stress <plugin binary> <work folder> [<budget in microseconds>]
+
+#include "XPLMPlugin.h"
+
+#include "xplm_mock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+// define the frame length of the virtual clock and the length of a scripted run in frames
+#define FRAME_TIME (1.0f / 60.0f)
+#define RUN_FRAMES 3600
+
+// define the default budget for the p99.9 frame time in microseconds
+#define DEFAULT_BUDGET 2000.0
+
+// define the number of elements of every array dataref
+#define ARRAY_SIZE 8
+
+// define the share of watched values that move on their own in every frame, like gyro drifts and autopilot-driven bugs
+#define MOVING_SHARE 0.02
+
+// define the share of watched values a plane load changes
+#define PLANE_LOAD_SHARE 0.3
+
+// watched value of the synthetic host
+typedef struct
+{
+    XPLMDataRef dataRef;
+    int element;
+    float value;
+} StressWatch;
+
+// global driver variables
+static std::vector<StressWatch> watches;
+static unsigned int randomState = 1;
+
+// return the wall time in seconds
+static double GetWallTime(void)
+{
+    struct timespec wall;
+    clock_gettime(CLOCK_MONOTONIC, &wall);
+    return wall.tv_sec + wall.tv_nsec * 1.0e-9;
+}
+
+// return a pseudo-random number in [0, 1) - the same sequence in every run
+static double NextRandom(void)
+{
+    randomState = randomState * 1103515245u + 12345u;
+    return (randomState >> 8) / 16777216.0;
+}
+
+// create the datarefs for the given number of watches - a quarter each are float, int, float array and int array elements - and write a config that watches all of them
+static int CreateHost(const char *folder, int count)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/x_hint.cfg", folder);
+    FILE *config = fopen(path, "w");
+    if (config == NULL)
+        return 0;
+
+    static const char *kinds[] = {"heading", "drift", "barometer"};
+    watches.clear();
+    for (int i = 0; i < count; i++)
+    {
+        char name[128];
+        StressWatch watch;
+        int group = i % 4;
+        watch.element = 0;
+        watch.value = 0.0f;
+
+        if (group == 0 || group == 1)
+        {
+            snprintf(name, sizeof(name), "stress/%s/%d", group == 0 ? "float" : "int", i);
+            watch.dataRef = MockAddDataRef(name, group == 0 ? xplmType_Float : xplmType_Int, 1);
+            fprintf(config, "watch %s %s\n", name, kinds[i % 3]);
+        }
+        else
+        {
+            // the elements of one array are spread over consecutive groups of four watches
+            int arrayIndex = i / 4 / ARRAY_SIZE, element = i / 4 % ARRAY_SIZE;
+            snprintf(name, sizeof(name), "stress/%s_array/%d", group == 2 ? "float" : "int", arrayIndex);
+            XPLMDataRef array = XPLMFindDataRef(name);
+            if (array == NULL)
+                array = MockAddDataRef(name, group == 2 ? xplmType_FloatArray : xplmType_IntArray, ARRAY_SIZE);
+            watch.dataRef = array;
+            watch.element = element;
+            fprintf(config, "watch %s[%d] %s\n", name, element, kinds[i % 3]);
+        }
+
+        watches.push_back(watch);
+    }
+
+    fclose(config);
+    return 1;
+}
+
+// move a watched value by the given amount
+static void MoveWatch(StressWatch *watch, float delta)
+{
+    watch->value += delta;
+    MockSetValue(watch->dataRef, watch->element, watch->value);
+}
+
+// return the given percentile of the frame times in microseconds
+static double GetPercentile(const std::vector<double> &sortedTimes, double fraction)
+{
+    if (sortedTimes.empty())
+        return 0.0;
+
+    return sortedTimes[(size_t) (fraction * (sortedTimes.size() - 1))] * 1.0e6;
+}
+
+// play the scripted run for one table size and return its sorted frame times in seconds
+static std::vector<double> RunScript(int count)
+{
+    std::vector<double> frameTimes;
+    std::vector<int> moving;
+    for (int i = 0; i < count * MOVING_SHARE; i++)
+        moving.push_back((int) (NextRandom() * count));
+
+    for (int frame = 0; frame < RUN_FRAMES; frame++)
+    {
+        double inputTime = 0.0;
+        int second = frame / 60;
+
+        // instruments that move on their own drift slowly all the time
+        for (size_t i = 0; i < moving.size(); i++)
+            MoveWatch(&watches[moving[i]], 0.01f);
+
+        // in every third second the pilot turns a knob - with the mouse wheel in the first half of the run and by clicking in the second
+        if (second % 3 == 1 && frame % 4 == 0)
+        {
+            int knob = (int) (NextRandom() * count);
+            MockSetMouseLocation(100 + frame % 500, 100 + frame % 300);
+            double start = GetWallTime();
+            if (second < 30)
+                MockWheel(1);
+            else
+                MockClick();
+            inputTime += GetWallTime() - start;
+            MoveWatch(&watches[knob], 1.0f);
+        }
+
+        // halfway through a plane is loaded, which changes a large part of the values at once
+        if (frame == RUN_FRAMES / 2)
+        {
+            for (int i = 0; i < count * PLANE_LOAD_SHARE; i++)
+                MoveWatch(&watches[(int) (NextRandom() * count)], 10.0f);
+            double start = GetWallTime();
+            MockSendMessage(XPLM_MSG_PLANE_LOADED);
+            inputTime += GetWallTime() - start;
+        }
+
+        frameTimes.push_back(MockRunFrame(FRAME_TIME) + inputTime);
+    }
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    return frameTimes;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3 && argc != 4)
+    {
+        fprintf(stderr, "usage: %s <plugin binary> <work folder> [<budget in microseconds>]\n", argv[0]);
+        return 2;
+    }
+
+    double budget = argc == 4 ? atof(argv[3]) : DEFAULT_BUDGET;
+    char path[1024];
+    mkdir(argv[2], 0755);
+    snprintf(path, sizeof(path), "%s/64/lin.xpl", argv[2]);
+    MockSetPluginPath(path);
+    snprintf(path, sizeof(path), "%s/", argv[2]);
+    MockSetSystemPath(path);
+    MockSetVerbose(getenv("STRESS_VERBOSE") != NULL);
+
+    int failures = 0;
+    static const int counts[] = {1000, 10000, 50000};
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        if (CreateHost(argv[2], counts[i]) == 0 || MockLoadPlugin(argv[1]) == 0)
+        {
+            fprintf(stderr, "stress: the plugin did not start with %d watches\n", counts[i]);
+            return 1;
+        }
+        MockSendMessage(XPLM_MSG_PLANE_LOADED);
+
+        std::vector<double> frameTimes = RunScript(counts[i]);
+        double p999 = GetPercentile(frameTimes, 0.999);
+        int passed = p999 <= budget;
+        failures += passed == 0;
+
+        printf("stress: %5d watches, %d frames, p50 %8.1f us, p99 %8.1f us, p99.9 %8.1f us, worst %8.1f us - %s the budget of %.0f us\n", counts[i], RUN_FRAMES, GetPercentile(frameTimes, 0.5), GetPercentile(frameTimes, 0.99), p999, GetPercentile(frameTimes, 1.0), passed != 0 ? "within" : "exceeds", budget);
+
+        if (MockUnloadPlugin() != 0)
+        {
+            fprintf(stderr, "stress: the plugin left registrations behind with %d watches\n", counts[i]);
+            failures++;
+        }
+    }
+
+    return failures != 0;
+}
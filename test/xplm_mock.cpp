@@ -0,0 +1,829 @@
+/* Copyright (C) 2015  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "XPLMDataAccess.h"
+#include "XPLMDisplay.h"
+#include "XPLMGraphics.h"
+#include "XPLMPlugin.h"
+#include "XPLMProcessing.h"
+#include "XPLMUtilities.h"
+
+#include "xplm_mock.h"
+
+#include <dlfcn.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <GL/gl.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// define the glyph atlas layout of the plugin - glyph quads are decoded back into characters from their texture coordinates
+#define MOCK_GLYPH_CHARACTERS " -./0123456789HMbdefghikmntz"
+#define MOCK_GLYPH_CELL_WIDTH 6
+#define MOCK_GLYPH_ATLAS_WIDTH 256
+
+// define the id of the loaded plugin, other plugins get the ids after it
+#define MOCK_PLUGIN_ID 1
+
+// dataref - either owned by the mock with its values stored here or published by the plugin through accessors
+typedef struct
+{
+    std::string name;
+    XPLMDataTypeID types;
+    std::vector<double> values;
+    double readDelay;
+    int published;
+    XPLMGetDatai_f readInt;
+    XPLMGetDataf_f readFloat;
+    XPLMGetDatad_f readDouble;
+    void *refcon;
+} MockDataRef;
+
+// flight loop - scheduled either for a time or for a frame
+typedef struct
+{
+    XPLMFlightLoop_f callback;
+    void *refcon;
+    int scheduled, destroyed;
+    double nextTime, lastCallTime;
+    long nextCycle;
+} MockFlightLoop;
+
+// registered draw callback
+typedef struct
+{
+    XPLMDrawCallback_f callback;
+    XPLMDrawingPhase phase;
+    int before;
+    void *refcon;
+} MockDrawCallback;
+
+// registered command handler
+typedef struct
+{
+    XPLMCommandCallback_f handler;
+    int before;
+    void *refcon;
+} MockCommandHandler;
+
+// command
+typedef struct
+{
+    std::string name;
+    std::vector<MockCommandHandler> handlers;
+} MockCommand;
+
+// other plugin
+typedef struct
+{
+    std::string signature;
+    int enabled;
+} MockPlugin;
+
+// plugin entry points
+typedef int (*XPluginStart_f)(char *outName, char *outSig, char *outDesc);
+typedef void (*XPluginStop_f)(void);
+typedef int (*XPluginEnable_f)(void);
+typedef void (*XPluginDisable_f)(void);
+typedef void (*XPluginReceiveMessage_f)(XPLMPluginID inFromWho, long inMessage, void *inParam);
+
+// global clock variables
+static double now = 0.0;
+static float frameLength = 0.0f;
+static long cycle = 0;
+
+// global host variables
+static std::map<std::string, MockDataRef*> dataRefs;
+static std::vector<MockDataRef*> retiredDataRefs;
+static std::vector<MockFlightLoop*> flightLoops;
+static std::vector<MockDrawCallback> drawCallbacks;
+static std::map<std::string, MockCommand*> commands;
+static std::vector<XPLMCreateWindow_t*> windows;
+static XPLMCreateWindow_t *frontWindow = NULL;
+static std::vector<MockPlugin> plugins;
+static unsigned long readCount = 0;
+static int mouseX = 100, mouseY = 100, screenWidth = 1920, screenHeight = 1080, nextTexture = 1, verbose = 0, drawnX = 0, drawnY = 0;
+static std::string pluginPath = "./x_hint/64/lin.xpl", systemPath = "./", drawnText, debugLog;
+
+// global GL variables - only the texture coordinates of the last glTexCoordPointer call are needed to decode glyph quads
+static const float *texCoords = NULL;
+
+// global plugin variables
+static void *pluginHandle = NULL;
+static XPluginStop_f pluginStop = NULL;
+static XPluginDisable_f pluginDisable = NULL;
+static XPluginReceiveMessage_f pluginReceiveMessage = NULL;
+
+// return the wall time in seconds
+static double GetWallTime(void)
+{
+    struct timespec wall;
+    clock_gettime(CLOCK_MONOTONIC, &wall);
+    return wall.tv_sec + wall.tv_nsec * 1.0e-9;
+}
+
+// count a read of a dataref and spend its read delay
+static void ChargeRead(MockDataRef *dataRef)
+{
+    readCount++;
+
+    if (dataRef->readDelay > 0.0)
+    {
+        double end = GetWallTime() + dataRef->readDelay;
+        while (GetWallTime() < end)
+            ;
+    }
+}
+
+// return an element of a dataref the mock owns or 0 if it is out of range
+static double GetElement(const MockDataRef *dataRef, int element)
+{
+    return element >= 0 && element < (int) dataRef->values.size() ? dataRef->values[element] : 0.0;
+}
+
+// set the time at which a flight loop runs next from an interval in flightloop-callback format
+static void ScheduleMockFlightLoop(MockFlightLoop *flightLoop, float interval, double base)
+{
+    flightLoop->scheduled = interval != 0.0f;
+    if (interval > 0.0f)
+    {
+        flightLoop->nextTime = base + interval;
+        flightLoop->nextCycle = 0;
+    }
+    else
+    {
+        flightLoop->nextTime = 0.0;
+        flightLoop->nextCycle = cycle + (long) ceilf(-interval);
+    }
+}
+
+void MockSetPluginPath(const char *path)
+{
+    pluginPath = path;
+}
+
+void MockSetSystemPath(const char *path)
+{
+    systemPath = path;
+}
+
+int MockLoadPlugin(const char *binaryPath)
+{
+    pluginHandle = dlopen(binaryPath, RTLD_NOW | RTLD_LOCAL);
+    if (pluginHandle == NULL)
+    {
+        fprintf(stderr, "mock: %s\n", dlerror());
+        return 0;
+    }
+
+    XPluginStart_f start = (XPluginStart_f) dlsym(pluginHandle, "XPluginStart");
+    XPluginEnable_f enable = (XPluginEnable_f) dlsym(pluginHandle, "XPluginEnable");
+    pluginStop = (XPluginStop_f) dlsym(pluginHandle, "XPluginStop");
+    pluginDisable = (XPluginDisable_f) dlsym(pluginHandle, "XPluginDisable");
+    pluginReceiveMessage = (XPluginReceiveMessage_f) dlsym(pluginHandle, "XPluginReceiveMessage");
+    if (start == NULL || enable == NULL || pluginStop == NULL || pluginDisable == NULL || pluginReceiveMessage == NULL)
+    {
+        fprintf(stderr, "mock: %s does not export all plugin entry points\n", binaryPath);
+        dlclose(pluginHandle);
+        pluginHandle = NULL;
+        return 0;
+    }
+
+    char name[256] = "", signature[256] = "", description[256] = "";
+    if (start(name, signature, description) == 0 || enable() == 0)
+    {
+        fprintf(stderr, "mock: %s refused to start\n", binaryPath);
+        return 0;
+    }
+
+    return 1;
+}
+
+int MockUnloadPlugin(void)
+{
+    if (pluginHandle == NULL)
+        return 0;
+
+    pluginDisable();
+    pluginStop();
+
+    // everything the plugin registered has to be gone after it stopped
+    int leftOver = (int) drawCallbacks.size();
+    for (size_t i = 0; i < flightLoops.size(); i++)
+        leftOver += flightLoops[i]->destroyed == 0;
+    for (std::map<std::string, MockCommand*>::iterator i = commands.begin(); i != commands.end(); ++i)
+        leftOver += (int) i->second->handlers.size();
+    for (std::map<std::string, MockDataRef*>::iterator i = dataRefs.begin(); i != dataRefs.end(); ++i)
+        leftOver += i->second->published;
+    if (leftOver != 0)
+        fprintf(stderr, "mock: plugin left %d callbacks, handlers or datarefs registered after it stopped\n", leftOver);
+
+    dlclose(pluginHandle);
+    pluginHandle = NULL;
+
+    return leftOver;
+}
+
+void MockSendMessage(long message)
+{
+    if (pluginReceiveMessage != NULL)
+        pluginReceiveMessage(XPLM_NO_PLUGIN_ID, message, NULL);
+}
+
+void MockBeginFrame(double time)
+{
+    frameLength = (float) (time - now);
+    now = time;
+    cycle++;
+    drawnText.clear();
+}
+
+double MockRunFlightLoops(void)
+{
+    double start = GetWallTime();
+
+    // flight loops may create, schedule or destroy flight loops, so they are iterated by index
+    for (size_t i = 0; i < flightLoops.size(); i++)
+    {
+        MockFlightLoop *flightLoop = flightLoops[i];
+        if (flightLoop->destroyed != 0 || flightLoop->scheduled == 0)
+            continue;
+        if (flightLoop->nextCycle != 0 ? cycle < flightLoop->nextCycle : now < flightLoop->nextTime)
+            continue;
+
+        float elapsed = (float) (now - flightLoop->lastCallTime);
+        flightLoop->lastCallTime = now;
+        ScheduleMockFlightLoop(flightLoop, flightLoop->callback(elapsed, frameLength, (int) cycle, flightLoop->refcon), now);
+    }
+
+    return GetWallTime() - start;
+}
+
+double MockRunDrawCallbacks(void)
+{
+    double start = GetWallTime();
+
+    // draw callbacks may unregister themselves
+    std::vector<MockDrawCallback> callbacks = drawCallbacks;
+    for (size_t i = 0; i < callbacks.size(); i++)
+        callbacks[i].callback(callbacks[i].phase, callbacks[i].before, callbacks[i].refcon);
+
+    return GetWallTime() - start;
+}
+
+double MockRunFrame(float seconds)
+{
+    double start = GetWallTime();
+
+    MockBeginFrame(now + seconds);
+    MockRunFlightLoops();
+    MockRunDrawCallbacks();
+
+    return GetWallTime() - start;
+}
+
+double MockGetTime(void)
+{
+    return now;
+}
+
+XPLMDataRef MockAddDataRef(const char *name, XPLMDataTypeID types, int size)
+{
+    MockDataRef *dataRef = new MockDataRef();
+    dataRef->name = name;
+    dataRef->types = types;
+    dataRef->values.assign(size > 1 ? size : 1, 0.0);
+    dataRef->readDelay = 0.0;
+    dataRef->published = 0;
+    dataRef->readInt = NULL;
+    dataRef->readFloat = NULL;
+    dataRef->readDouble = NULL;
+    dataRef->refcon = NULL;
+
+    if (dataRefs.count(name) != 0)
+        retiredDataRefs.push_back(dataRefs[name]);
+    dataRefs[name] = dataRef;
+
+    return dataRef;
+}
+
+void MockSetValue(XPLMDataRef dataRef, int element, double value)
+{
+    MockDataRef *mockDataRef = (MockDataRef*) dataRef;
+    if (element >= 0 && element < (int) mockDataRef->values.size())
+        mockDataRef->values[element] = value;
+}
+
+void MockSetReadDelay(XPLMDataRef dataRef, double seconds)
+{
+    ((MockDataRef*) dataRef)->readDelay = seconds;
+}
+
+unsigned long MockGetReadCount(void)
+{
+    return readCount;
+}
+
+void MockResetReadCount(void)
+{
+    readCount = 0;
+}
+
+XPLMCommandRef MockAddCommand(const char *name)
+{
+    if (commands.count(name) == 0)
+    {
+        MockCommand *command = new MockCommand();
+        command->name = name;
+        commands[name] = command;
+    }
+
+    return commands[name];
+}
+
+void MockFireCommand(XPLMCommandRef command, XPLMCommandPhase phase)
+{
+    // handlers may unregister themselves, a handler that returns 0 ends the command's processing
+    std::vector<MockCommandHandler> handlers = ((MockCommand*) command)->handlers;
+    for (int before = 1; before >= 0; before--)
+    {
+        for (size_t i = 0; i < handlers.size(); i++)
+        {
+            if (handlers[i].before == before && handlers[i].handler(command, phase, handlers[i].refcon) == 0)
+                return;
+        }
+    }
+}
+
+// return 1 if the mouse is inside the geometry of the frontmost window, which is the only one that gets mouse events
+static int IsMouseInFrontWindow(void)
+{
+    return frontWindow != NULL && mouseX >= frontWindow->left && mouseX < frontWindow->right && mouseY >= frontWindow->bottom && mouseY < frontWindow->top;
+}
+
+void MockClick(void)
+{
+    if (IsMouseInFrontWindow() != 0 && frontWindow->handleMouseClickFunc != NULL)
+        frontWindow->handleMouseClickFunc(frontWindow, mouseX, mouseY, xplm_MouseDown, frontWindow->refcon);
+}
+
+void MockWheel(int clicks)
+{
+    if (IsMouseInFrontWindow() != 0 && frontWindow->handleMouseWheelFunc != NULL)
+        frontWindow->handleMouseWheelFunc(frontWindow, mouseX, mouseY, 0, clicks, frontWindow->refcon);
+}
+
+void MockSetMouseLocation(int x, int y)
+{
+    mouseX = x;
+    mouseY = y;
+}
+
+void MockSetScreenSize(int width, int height)
+{
+    screenWidth = width;
+    screenHeight = height;
+}
+
+void MockLoseFront(void)
+{
+    frontWindow = NULL;
+}
+
+void MockSetPluginEnabled(const char *signature, int enabled)
+{
+    for (size_t i = 0; i < plugins.size(); i++)
+    {
+        if (plugins[i].signature == signature)
+        {
+            plugins[i].enabled = enabled;
+            return;
+        }
+    }
+
+    MockPlugin plugin;
+    plugin.signature = signature;
+    plugin.enabled = enabled;
+    plugins.push_back(plugin);
+}
+
+const char *MockGetDrawnText(void)
+{
+    return drawnText.c_str();
+}
+
+void MockGetDrawnPosition(int *x, int *y)
+{
+    *x = drawnX;
+    *y = drawnY;
+}
+
+int MockGetDrawCallbackCount(void)
+{
+    return (int) drawCallbacks.size();
+}
+
+void MockSetVerbose(int enabled)
+{
+    verbose = enabled;
+}
+
+int MockLogContains(const char *text)
+{
+    return debugLog.find(text) != std::string::npos;
+}
+
+void MockClearLog(void)
+{
+    debugLog.clear();
+}
+
+// XPLMDataAccess
+
+XPLMDataRef XPLMFindDataRef(const char *inDataRefName)
+{
+    std::map<std::string, MockDataRef*>::iterator i = dataRefs.find(inDataRefName);
+    return i != dataRefs.end() ? i->second : NULL;
+}
+
+XPLMDataTypeID XPLMGetDataRefTypes(XPLMDataRef inDataRef)
+{
+    return inDataRef != NULL ? ((MockDataRef*) inDataRef)->types : xplmType_Unknown;
+}
+
+int XPLMGetDatai(XPLMDataRef inDataRef)
+{
+    MockDataRef *dataRef = (MockDataRef*) inDataRef;
+    ChargeRead(dataRef);
+    return dataRef->readInt != NULL ? dataRef->readInt(dataRef->refcon) : (int) GetElement(dataRef, 0);
+}
+
+float XPLMGetDataf(XPLMDataRef inDataRef)
+{
+    MockDataRef *dataRef = (MockDataRef*) inDataRef;
+    ChargeRead(dataRef);
+    return dataRef->readFloat != NULL ? dataRef->readFloat(dataRef->refcon) : (float) GetElement(dataRef, 0);
+}
+
+double XPLMGetDatad(XPLMDataRef inDataRef)
+{
+    MockDataRef *dataRef = (MockDataRef*) inDataRef;
+    ChargeRead(dataRef);
+    return dataRef->readDouble != NULL ? dataRef->readDouble(dataRef->refcon) : GetElement(dataRef, 0);
+}
+
+int XPLMGetDatavi(XPLMDataRef inDataRef, int *outValues, int inOffset, int inMax)
+{
+    MockDataRef *dataRef = (MockDataRef*) inDataRef;
+    ChargeRead(dataRef);
+    if (outValues == NULL)
+        return (int) dataRef->values.size();
+
+    int count = 0;
+    for (; count < inMax && inOffset + count < (int) dataRef->values.size(); count++)
+        outValues[count] = (int) dataRef->values[inOffset + count];
+
+    return count;
+}
+
+int XPLMGetDatavf(XPLMDataRef inDataRef, float *outValues, int inOffset, int inMax)
+{
+    MockDataRef *dataRef = (MockDataRef*) inDataRef;
+    ChargeRead(dataRef);
+    if (outValues == NULL)
+        return (int) dataRef->values.size();
+
+    int count = 0;
+    for (; count < inMax && inOffset + count < (int) dataRef->values.size(); count++)
+        outValues[count] = (float) dataRef->values[inOffset + count];
+
+    return count;
+}
+
+XPLMDataRef XPLMRegisterDataAccessor(const char *inDataName, XPLMDataTypeID inDataType, int inIsWritable, XPLMGetDatai_f inReadInt, XPLMSetDatai_f inWriteInt, XPLMGetDataf_f inReadFloat, XPLMSetDataf_f inWriteFloat, XPLMGetDatad_f inReadDouble, XPLMSetDatad_f inWriteDouble, XPLMGetDatavi_f inReadIntArray, XPLMSetDatavi_f inWriteIntArray, XPLMGetDatavf_f inReadFloatArray, XPLMSetDatavf_f inWriteFloatArray, XPLMGetDatab_f inReadData, XPLMSetDatab_f inWriteData, void *inReadRefcon, void *inWriteRefcon)
+{
+    MockDataRef *dataRef = (MockDataRef*) MockAddDataRef(inDataName, inDataType, 1);
+    dataRef->published = 1;
+    dataRef->readInt = inReadInt;
+    dataRef->readFloat = inReadFloat;
+    dataRef->readDouble = inReadDouble;
+    dataRef->refcon = inReadRefcon;
+
+    return dataRef;
+}
+
+void XPLMUnregisterDataAccessor(XPLMDataRef inDataRef)
+{
+    // the handle stays valid, the dataref can no longer be found
+    MockDataRef *dataRef = (MockDataRef*) inDataRef;
+    if (dataRefs.count(dataRef->name) != 0 && dataRefs[dataRef->name] == dataRef)
+        dataRefs.erase(dataRef->name);
+    dataRef->published = 0;
+    retiredDataRefs.push_back(dataRef);
+}
+
+// XPLMDisplay
+
+int XPLMRegisterDrawCallback(XPLMDrawCallback_f inCallback, XPLMDrawingPhase inPhase, int inWantsBefore, void *inRefcon)
+{
+    MockDrawCallback drawCallback = {inCallback, inPhase, inWantsBefore, inRefcon};
+    drawCallbacks.push_back(drawCallback);
+
+    return 1;
+}
+
+int XPLMUnregisterDrawCallback(XPLMDrawCallback_f inCallback, XPLMDrawingPhase inPhase, int inWantsBefore, void *inRefcon)
+{
+    for (size_t i = 0; i < drawCallbacks.size(); i++)
+    {
+        if (drawCallbacks[i].callback == inCallback && drawCallbacks[i].phase == inPhase && drawCallbacks[i].before == inWantsBefore && drawCallbacks[i].refcon == inRefcon)
+        {
+            drawCallbacks.erase(drawCallbacks.begin() + i);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+XPLMWindowID XPLMCreateWindowEx(XPLMCreateWindow_t *inParams)
+{
+    XPLMCreateWindow_t *window = new XPLMCreateWindow_t();
+    memcpy(window, inParams, inParams->structSize < (int) sizeof(*window) ? inParams->structSize : sizeof(*window));
+    windows.push_back(window);
+    frontWindow = window;
+
+    return window;
+}
+
+void XPLMSetWindowGeometry(XPLMWindowID inWindowID, int inLeft, int inTop, int inRight, int inBottom)
+{
+    XPLMCreateWindow_t *window = (XPLMCreateWindow_t*) inWindowID;
+    window->left = inLeft;
+    window->top = inTop;
+    window->right = inRight;
+    window->bottom = inBottom;
+}
+
+void XPLMBringWindowToFront(XPLMWindowID inWindow)
+{
+    frontWindow = (XPLMCreateWindow_t*) inWindow;
+}
+
+int XPLMIsWindowInFront(XPLMWindowID inWindow)
+{
+    return frontWindow == inWindow;
+}
+
+void XPLMGetMouseLocation(int *outX, int *outY)
+{
+    if (outX != NULL)
+        *outX = mouseX;
+    if (outY != NULL)
+        *outY = mouseY;
+}
+
+void XPLMGetScreenSize(int *outWidth, int *outHeight)
+{
+    if (outWidth != NULL)
+        *outWidth = screenWidth;
+    if (outHeight != NULL)
+        *outHeight = screenHeight;
+}
+
+// XPLMGraphics
+
+void XPLMSetGraphicsState(int inEnableFog, int inNumberTexUnits, int inEnableLighting, int inEnableAlphaTesting, int inEnableAlphaBlending, int inEnableDepthTesting, int inEnableDepthWriting)
+{
+}
+
+void XPLMBindTexture2d(int inTextureNum, int inTextureUnit)
+{
+}
+
+void XPLMGenerateTextureNumbers(int *outTextureIDs, int inCount)
+{
+    for (int i = 0; i < inCount; i++)
+        outTextureIDs[i] = nextTexture++;
+}
+
+void XPLMDrawString(float *inColorRGB, int inXOffset, int inYOffset, char *inChar, int *inWordWrapWidth, XPLMFontID inFontID)
+{
+    drawnText += inChar;
+    drawnX = inXOffset;
+    drawnY = inYOffset;
+}
+
+// XPLMPlugin
+
+XPLMPluginID XPLMGetMyID(void)
+{
+    return MOCK_PLUGIN_ID;
+}
+
+void XPLMGetPluginInfo(XPLMPluginID inPlugin, char *outName, char *outFilePath, char *outSignature, char *outDescription)
+{
+    if (outName != NULL)
+        outName[0] = '\0';
+    if (outFilePath != NULL)
+        strcpy(outFilePath, inPlugin == MOCK_PLUGIN_ID ? pluginPath.c_str() : "");
+    if (outSignature != NULL)
+        outSignature[0] = '\0';
+    if (outDescription != NULL)
+        outDescription[0] = '\0';
+}
+
+XPLMPluginID XPLMFindPluginBySignature(const char *inSignature)
+{
+    for (size_t i = 0; i < plugins.size(); i++)
+    {
+        if (plugins[i].signature == inSignature)
+            return MOCK_PLUGIN_ID + 1 + (int) i;
+    }
+
+    return XPLM_NO_PLUGIN_ID;
+}
+
+int XPLMIsPluginEnabled(XPLMPluginID inPluginID)
+{
+    if (inPluginID == MOCK_PLUGIN_ID)
+        return 1;
+
+    int i = inPluginID - MOCK_PLUGIN_ID - 1;
+    return i >= 0 && i < (int) plugins.size() ? plugins[i].enabled : 0;
+}
+
+int XPLMHasFeature(const char *inFeature)
+{
+    return 1;
+}
+
+void XPLMEnableFeature(const char *inFeature, int inEnable)
+{
+}
+
+// XPLMProcessing
+
+float XPLMGetElapsedTime(void)
+{
+    return (float) now;
+}
+
+int XPLMGetCycleNumber(void)
+{
+    return (int) cycle;
+}
+
+XPLMFlightLoopID XPLMCreateFlightLoop(XPLMCreateFlightLoop_t *inParams)
+{
+    MockFlightLoop *flightLoop = new MockFlightLoop();
+    flightLoop->callback = inParams->callbackFunc;
+    flightLoop->refcon = inParams->refcon;
+    flightLoop->scheduled = 0;
+    flightLoop->destroyed = 0;
+    flightLoop->nextTime = 0.0;
+    flightLoop->lastCallTime = now;
+    flightLoop->nextCycle = 0;
+    flightLoops.push_back(flightLoop);
+
+    return flightLoop;
+}
+
+void XPLMDestroyFlightLoop(XPLMFlightLoopID inFlightLoopID)
+{
+    ((MockFlightLoop*) inFlightLoopID)->destroyed = 1;
+}
+
+void XPLMScheduleFlightLoop(XPLMFlightLoopID inFlightLoopID, float inInterval, int inRelativeToNow)
+{
+    MockFlightLoop *flightLoop = (MockFlightLoop*) inFlightLoopID;
+    ScheduleMockFlightLoop(flightLoop, inInterval, inRelativeToNow != 0 ? now : flightLoop->lastCallTime);
+}
+
+// XPLMUtilities
+
+void XPLMGetSystemPath(char *outSystemPath)
+{
+    strcpy(outSystemPath, systemPath.c_str());
+}
+
+const char *XPLMGetDirectorySeparator(void)
+{
+    return "/";
+}
+
+void XPLMDebugString(const char *inString)
+{
+    debugLog += inString;
+    if (verbose != 0)
+        fputs(inString, stdout);
+}
+
+XPLMCommandRef XPLMFindCommand(const char *inName)
+{
+    std::map<std::string, MockCommand*>::iterator i = commands.find(inName);
+    return i != commands.end() ? i->second : NULL;
+}
+
+void XPLMRegisterCommandHandler(XPLMCommandRef inComand, XPLMCommandCallback_f inHandler, int inBefore, void *inRefcon)
+{
+    MockCommandHandler handler = {inHandler, inBefore, inRefcon};
+    ((MockCommand*) inComand)->handlers.push_back(handler);
+}
+
+void XPLMUnregisterCommandHandler(XPLMCommandRef inComand, XPLMCommandCallback_f inHandler, int inBefore, void *inRefcon)
+{
+    std::vector<MockCommandHandler> &handlers = ((MockCommand*) inComand)->handlers;
+    for (size_t i = 0; i < handlers.size(); i++)
+    {
+        if (handlers[i].handler == inHandler && handlers[i].before == inBefore && handlers[i].refcon == inRefcon)
+        {
+            handlers.erase(handlers.begin() + i);
+            return;
+        }
+    }
+}
+
+// OpenGL - state changes are ignored, glyph quads are decoded into drawnText and translations are kept as the position they are drawn at
+
+void glPixelStorei(GLenum pname, GLint param)
+{
+}
+
+void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *pixels)
+{
+}
+
+void glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+}
+
+void glDeleteTextures(GLsizei n, const GLuint *textures)
+{
+}
+
+void glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+}
+
+void glPushMatrix(void)
+{
+}
+
+void glPopMatrix(void)
+{
+}
+
+void glTranslatef(GLfloat x, GLfloat y, GLfloat z)
+{
+    drawnX = (int) x;
+    drawnY = (int) y;
+}
+
+void glEnableClientState(GLenum cap)
+{
+}
+
+void glDisableClientState(GLenum cap)
+{
+}
+
+void glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *ptr)
+{
+}
+
+void glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *ptr)
+{
+    texCoords = (const float*) ptr;
+}
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    static const char glyphCharacters[] = MOCK_GLYPH_CHARACTERS;
+
+    // every quad starts with the lower left corner of its glyph cell
+    for (int quad = 0; texCoords != NULL && quad < count / 4; quad++)
+    {
+        int glyph = (int) lrintf(texCoords[(first + quad * 4) * 2] * MOCK_GLYPH_ATLAS_WIDTH / MOCK_GLYPH_CELL_WIDTH);
+        drawnText += glyph >= 0 && glyph < (int) sizeof(glyphCharacters) - 1 ? glyphCharacters[glyph] : '?';
+    }
+}
@@ -0,0 +1,103 @@
+/* Copyright (C) 2015  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// headless stand-in for the XPLM and GL functions the plugin imports - a driver links against it, loads the plugin binary and runs frames on a virtual clock that only advances when the driver says so, so a run is deterministic and much faster than real time
+
+#ifndef XPLM_MOCK_H
+#define XPLM_MOCK_H
+
+#include "XPLMDataAccess.h"
+#include "XPLMUtilities.h"
+
+// set the path XPLMGetPluginInfo reports for the plugin binary - the plugin reads its config from and writes its files to the folder above it
+void MockSetPluginPath(const char *path);
+
+// set the path XPLMGetSystemPath reports - must end with a separator, trace files go to its Output folder
+void MockSetSystemPath(const char *path);
+
+// load a plugin binary and start and enable it - returns 0 if it could not be loaded or refused to start
+int MockLoadPlugin(const char *binaryPath);
+
+// disable, stop and unload the plugin - returns the number of callbacks, handlers and datarefs it left registered
+int MockUnloadPlugin(void);
+
+// send a message to the plugin as if it came from X-Plane
+void MockSendMessage(long message);
+
+// advance the virtual clock by the given number of seconds, then run all due flight loops and all registered draw callbacks - returns the wall time the frame took in seconds
+double MockRunFrame(float seconds);
+
+// the steps of MockRunFrame for drivers that send input between them - start a frame at the given virtual time, which must not lie before the current one, then run the due flight loops and the draw callbacks, each returns the wall time it took in seconds
+void MockBeginFrame(double time);
+double MockRunFlightLoops(void);
+double MockRunDrawCallbacks(void);
+
+// return the virtual clock in seconds
+double MockGetTime(void);
+
+// create a dataref of the given types - array datarefs get the given number of elements, all values start at 0
+XPLMDataRef MockAddDataRef(const char *name, XPLMDataTypeID types, int size);
+
+// set an element of a dataref - scalar datarefs only have element 0
+void MockSetValue(XPLMDataRef dataRef, int element, double value);
+
+// make every read of a dataref take the given wall time, to simulate datarefs that are expensive to read
+void MockSetReadDelay(XPLMDataRef dataRef, double seconds);
+
+// return the number of dataref reads the plugin made since the last reset
+unsigned long MockGetReadCount(void);
+void MockResetReadCount(void);
+
+// create a command that XPLMFindCommand finds
+XPLMCommandRef MockAddCommand(const char *name);
+
+// run the handlers of a command in the given phase - the ones registered before X-Plane's own handling first, the driver then applies the command's effect itself
+void MockFireCommand(XPLMCommandRef command, XPLMCommandPhase phase);
+
+// send a mouse click or wheel event to the frontmost window of the plugin at the current mouse location - the event is lost if the mouse is outside the window
+void MockClick(void);
+void MockWheel(int clicks);
+
+// move the mouse
+void MockSetMouseLocation(int x, int y);
+
+// change the screen size the plugin sees
+void MockSetScreenSize(int width, int height);
+
+// let another window take the front
+void MockLoseFront(void);
+
+// add another plugin XPLMFindPluginBySignature finds, or change whether it is enabled
+void MockSetPluginEnabled(const char *signature, int enabled);
+
+// return the text the draw callbacks drew in the last frame - the glyph quads of the plugin's atlas are decoded back into characters, strings drawn with XPLMDrawString are appended as they are
+const char *MockGetDrawnText(void);
+
+// get the screen position the last text was drawn at
+void MockGetDrawnPosition(int *x, int *y);
+
+// return the number of registered draw callbacks
+int MockGetDrawCallbackCount(void);
+
+// echo the plugin's log messages to stdout
+void MockSetVerbose(int verbose);
+
+// return 1 if the plugin logged a message containing the given text since the last clear
+int MockLogContains(const char *text);
+void MockClearLog(void);
+
+#endif
@@ -20,213 +20,2984 @@
 #include "XPLMGraphics.h"
 #include "XPLMPlugin.h"
 #include "XPLMProcessing.h"
+#include "XPLMUtilities.h"
 
-#include <float.h>
+#include <limits.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#if IBM
+#include <windows.h>
+#include <GL/gl.h>
+#elif APL
+#include <mach/mach_time.h>
+#include <OpenGL/gl.h>
+#include <pthread.h>
+#else
+#include <GL/gl.h>
+#include <pthread.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <immintrin.h>
+#include <x86intrin.h>
+#define WATCH_SIMD 1
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#define NO_INLINE __attribute__((noinline))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#include <immintrin.h>
+#define WATCH_SIMD 1
+#define TARGET_SSE2
+#define TARGET_AVX2
+#define TARGET_AVX512
+#define NO_INLINE __declspec(noinline)
+#else
+#define NO_INLINE
+#endif
+
+// acquire loads and release stores of the indices the sim thread and the trace flush thread share - plain volatile accesses have these semantics with MSVC on x86
+#ifdef _MSC_VER
+#define LOAD_ACQUIRE(pointer) (*(volatile unsigned int*) (pointer))
+#define STORE_RELEASE(pointer, value) (*(volatile unsigned int*) (pointer) = (value))
+#else
+#define LOAD_ACQUIRE(pointer) __atomic_load_n(pointer, __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(pointer, value) __atomic_store_n(pointer, value, __ATOMIC_RELEASE)
+#endif
+
+// USDT probes - each probe is a single nop plus an ELF note in the layout of SystemTap's sys/sdt.h, so perf, bpftrace and SystemTap can attach to it in a running sim, arguments are passed as signed longs and are only computed while a tracer is attached and has raised the probe's semaphore
+#if LIN && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#ifdef __x86_64__
+#define USDT_ADDRESS ".8byte"
+#define USDT_ARGUMENT "-8@"
+#else
+#define USDT_ADDRESS ".4byte"
+#define USDT_ARGUMENT "-4@"
+#endif
+#define USDT_NOTE(name, arguments) \
+    "990: nop\n" \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+    ".balign 4\n" \
+    ".4byte 992f-991f,994f-993f,3\n" \
+    "991: .asciz \"stapsdt\"\n" \
+    "992: .balign 4\n" \
+    "993: " USDT_ADDRESS " 990b\n" \
+    USDT_ADDRESS " _.stapsdt.base\n" \
+    USDT_ADDRESS " x_hint_" name "_semaphore\n" \
+    ".asciz \"x_hint\"\n" \
+    ".asciz \"" name "\"\n" \
+    ".asciz \"" arguments "\"\n" \
+    "994: .balign 4\n" \
+    ".popsection\n" \
+    ".ifndef _.stapsdt.base\n" \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+    ".weak _.stapsdt.base\n" \
+    ".hidden _.stapsdt.base\n" \
+    "_.stapsdt.base: .space 1\n" \
+    ".size _.stapsdt.base,1\n" \
+    ".popsection\n" \
+    ".endif\n"
+#define USDT_SEMAPHORE(name) static volatile unsigned short name##Semaphore __asm__("x_hint_" #name "_semaphore") __attribute__((used, section(".probes"))) = 0
+#define USDT_PROBE1(name, a) do { if (name##Semaphore != 0) __asm__ __volatile__(USDT_NOTE(#name, USDT_ARGUMENT "%0") : : "nor" (GetProbeArgument(a))); } while (0)
+#define USDT_PROBE2(name, a, b) do { if (name##Semaphore != 0) __asm__ __volatile__(USDT_NOTE(#name, USDT_ARGUMENT "%0 " USDT_ARGUMENT "%1") : : "nor" (GetProbeArgument(a)), "nor" (GetProbeArgument(b))); } while (0)
+
+// semaphores of the probes - tracers count them up while they are attached
+USDT_SEMAPHORE(flight_loop_entry);
+USDT_SEMAPHORE(flight_loop_exit);
+USDT_SEMAPHORE(hint_format);
+USDT_SEMAPHORE(change_detected);
+USDT_SEMAPHORE(draw);
+
+// convert a probe argument to a signed long - values outside its range are clamped and NaN is passed as 0, so values in thousandths cannot overflow where longs have 32 bits
+static inline long GetProbeArgument(double value)
+{
+    if (value != value)
+        return 0;
+    if (value >= (double) LONG_MAX)
+        return LONG_MAX;
+    if (value <= (double) LONG_MIN)
+        return LONG_MIN;
+
+    return (long) value;
+}
+#else
+#define USDT_PROBE1(name, a) ((void) 0)
+#define USDT_PROBE2(name, a, b) ((void) 0)
+#endif
 
 // define name
 #define NAME "X-hint"
 #define NAME_LOWERCASE "x_hint"
 
-// define version
-#define VERSION "0.3"
+// define version
+#define VERSION "0.3"
+
+// define QPAC A320 plugin signature
+#define QPAC_A320_PLUGIN_SIGNATURE "QPAC.airbus.fbw"
+
+// define config file name - the file is optional and located in the plugin's folder
+#define CONFIG_FILE_NAME NAME_LOWERCASE ".cfg"
+
+// define session recording file format - a magic string and version followed by records that start with one of the record types, watch and command records describe the watch table, event records carry the frame time and are followed by the value and suppression records of what the plugin read while handling them and by the filter records of entries a plane load gave new noise filters
+#define SESSION_MAGIC "XHINTREC"
+#define SESSION_VERSION 4
+#define SESSION_RECORD_WATCH 'W'
+#define SESSION_RECORD_COMMAND 'M'
+#define SESSION_RECORD_VALUE 'V'
+#define SESSION_RECORD_SUPPRESSION 'Q'
+#define SESSION_RECORD_FRAME 'F'
+#define SESSION_RECORD_CLICK 'C'
+#define SESSION_RECORD_WHEEL 'S'
+#define SESSION_RECORD_COMMAND_PHASE 'K'
+#define SESSION_RECORD_PLANE_LOADED 'L'
+#define SESSION_RECORD_PLANE_UNLOADED 'U'
+#define SESSION_RECORD_HINT 'H'
+#define SESSION_RECORD_FILTER 'R'
+#define SESSION_BUFFER_SIZE 65536
+
+// define profile file name - written to the plugin's folder when profiling is enabled in the config file
+#define PROFILE_FILE_NAME NAME_LOWERCASE "_profile.csv"
+
+// define trace ring buffer size in events - a power of two, events that do not fit because the flush thread fell behind are dropped
+#define TRACE_BUFFER_SIZE 65536
+
+// define interval in milliseconds the trace flush thread writes the ring buffer to the trace file in
+#define TRACE_FLUSH_INTERVAL 100
+
+// define maximum number of command bindings
+#define MAX_COMMAND_BINDINGS 256
+
+// define maximum number of plugin suppression rules
+#define MAX_SUPPRESSION_RULES 64
+
+// define maximum number of noise filter rules
+#define MAX_FILTER_RULES 64
+
+// define maximum number of config lines that wait for their datarefs or commands
+#define MAX_PENDING_LINES 64
+
+// define hint duration
+#define HINT_DURATION 4.0f
+
+// define hint text size
+#define HINT_TEXT_LENGTH 32
+
+// define the largest magnitude the hint formatter writes digits for, larger values are written as dashes
+#define FORMAT_LIMIT 1.0e9f
+
+// define glyph atlas layout - glyphs are 5x7 pixel bitmaps stored side by side in cells that are one pixel wider, drawn at twice their size
+#define GLYPH_WIDTH 5
+#define GLYPH_HEIGHT 7
+#define GLYPH_CELL_WIDTH 6
+#define GLYPH_SCALE 2.0f
+#define GLYPH_ATLAS_WIDTH 256
+#define GLYPH_ATLAS_HEIGHT 8
+
+// define hint text offset from the mouse location
+#define HINT_OFFSET_X 40
+#define HINT_OFFSET_Y -40
+
+// define how long datarefs are polled after the last mouse input and the polling interval during that time
+#define POLL_BURST_DURATION 1.0f
+#define POLL_INTERVAL 0.1f
+
+// define how often the fake window is checked for screen size changes and for having lost the front
+#define FAKE_WINDOW_CHECK_INTERVAL 1.0f
+
+// define scheduler tasks
+#define TASK_UPDATE_FAKE_WINDOW 0
+#define TASK_POLL_WATCHES 1
+#define TASK_UPDATE_HINT 2
+#define TASK_READ_COMMAND_WATCHES 3
+#define TASK_COUNT 4
+
+// define plugin-wide time budget per scheduler pass in seconds - due tasks that do not fit are deferred to the next frame
+#define SCHEDULER_BUDGET 0.0005
+
+// define the default budget for the plugin's own cost per frame in seconds and the levels the governor steps down through while it is exceeded
+#define GOVERNOR_BUDGET 0.001
+#define GOVERNOR_FULL_OPERATION 0
+#define GOVERNOR_REDUCE_POLL_RATE 1
+#define GOVERNOR_DROP_EXPENSIVE 2
+#define GOVERNOR_SUSPEND_DRAWING 3
+#define GOVERNOR_LEVEL_COUNT 4
+
+// define how many frames within which time have to exceed the budget and how long a level has to settle before the governor steps down further
+#define GOVERNOR_OVERRUN_FRAMES 3
+#define GOVERNOR_OVERRUN_WINDOW 1.0f
+#define GOVERNOR_SETTLE_TIME 0.5f
+
+// define which share of the budget frames have to stay below and for how long before the governor steps up again
+#define GOVERNOR_RECOVERY_SHARE 0.5
+#define GOVERNOR_RECOVERY_TIME 5.0f
+#define GOVERNOR_MAX_RECOVERY_TIME 320.0f
+
+// define the factor the poll interval is stretched by and the share of the budget a single read may take before its entry is dropped
+#define GOVERNOR_POLL_FACTOR 4.0f
+#define GOVERNOR_EXPENSIVE_SHARE 0.125
+
+// define profiling probes - the first probes correspond to the scheduler tasks
+#define PROBE_DRAW TASK_COUNT
+#define PROBE_DISPLAY_HINT (TASK_COUNT + 1)
+#define PROBE_MOUSE_INPUT (TASK_COUNT + 2)
+#define PROBE_FLIGHT_LOOP (TASK_COUNT + 3)
+#define PROBE_COUNT (TASK_COUNT + 4)
+
+// define latency histogram layout - latencies below 2^HISTOGRAM_SUB_BITS ticks get a bucket each, every further power of two is split into 2^HISTOGRAM_SUB_BITS buckets, so a bucket is at most 1/8 wider than its lower bound
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_BUCKET_COUNT ((64 - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS)
+
+// define the statistics every probe publishes as x_hint/perf/<probe>/<statistic> dataref - the count is an int, all others are floats in nanoseconds
+#define PERF_COUNT 0
+#define PERF_P50 1
+#define PERF_P90 2
+#define PERF_P99 3
+#define PERF_P999 4
+#define PERF_WORST 5
+#define PERF_STATISTIC_COUNT 6
+
+// define timing wheel - every watch table entry has its own poll interval counted in ticks of POLL_INTERVAL, it drops to the minimum when the dataref changes and on the first poll after mouse input and doubles up to the maximum while it does not
+#define WHEEL_SLOT_COUNT 32
+#define POLL_MIN_TICKS 1
+
+// define the link of a watch table entry that is in no slot of the timing wheel
+#define WHEEL_UNLINKED -2
+#define POLL_MAX_TICKS 16
+
+// define default time budget per poll in seconds and the number of entries scanned between two budget checks - can be changed in the config file
+#define SCAN_BUDGET 0.0002
+#define SCAN_CHUNK_SIZE 256
+
+// define watch kinds
+#define WATCH_KIND_DRIFT 0
+#define WATCH_KIND_HEADING 1
+#define WATCH_KIND_BAROMETER 2
+
+// define bitmask of watch kinds
+#define WATCH_KIND_BIT(kind) (1 << (kind))
+
+// define display quanta - the smallest step each hint kind shows, a change is only detected if the value moves to another step
+#define DRIFT_QUANTUM 0.1f
+#define HEADING_QUANTUM 1.0f
+#define BAROMETER_QUANTUM 0.01f
+
+// define the decimals each hint kind is formatted with - the keys of the entries round like the formatter at these decimals
+#define DRIFT_DECIMALS 1
+#define HEADING_DECIMALS 0
+#define BAROMETER_DECIMALS 2
+
+// define wrap ranges - read values are wrapped into [min, min + range), a range of 0 turns wrapping off
+#define DRIFT_WRAP_MIN -180.0f
+#define DRIFT_WRAP_RANGE 360.0f
+#define HEADING_WRAP_MIN 0.0f
+#define HEADING_WRAP_RANGE 360.0f
+
+// define the largest number of quanta a value may be away from 0, all values beyond share one key
+#define QUANTIZE_LIMIT 1000000000
+
+// define conversion factor from inches of mercury to millibars
+#define INHG_TO_MB 33.8638866667f
+
+// define alias states of a copilot entry - it is observed after every plane load, once it moved together with its pilot entry ALIAS_CONFIRM_CHANGES times it takes the pilot value over without being read and is only verified on the first poll of the pilot entry after input, it is split off again as soon as the two differ
+#define ALIAS_OBSERVING 0
+#define ALIAS_CONFIRMED 1
+#define ALIAS_INDEPENDENT 2
+#define ALIAS_CONFIRM_CHANGES 3
+
+// define governor states of an entry - a dropped entry is not read until the governor recovers, a restored one takes the value of its next read over as baseline
+#define WATCH_POLLED 0
+#define WATCH_DROPPED 1
+#define WATCH_RESTORED 2
+
+// scheduler task type - the return value has the same meaning as the one of a flightloop-callback: positive values are seconds, negative values mean the next frame and 0 deactivates the task until ScheduleTask is called
+typedef float (*SchedulerTask)(float currentTime);
+
+// command binding - when the command fires the watched dataref is read once right after X-Plane handled the command
+typedef struct
+{
+    char commandName[256];
+    XPLMCommandRef command;
+    XPLMDataRef dataRef;
+    int element;
+    int watchIndex;
+} CommandBinding;
+
+// plugin suppression rule - while the plugin with the given signature is enabled no hints of the given kinds are displayed
+typedef struct
+{
+    char signature[256];
+    int suppressedKinds;
+} SuppressionRule;
+
+// noise filter rule - smoothing is the weight of a new reading in the moving average (1 turns it off), hysteresis is the number of quanta a value has to move away from the last accepted one and debounce the number of further polls a changed key has to stay the same for
+typedef struct
+{
+    XPLMDataRef dataRef;
+    int element;
+    float smoothing;
+    float hysteresis;
+    int debounce;
+} FilterRule;
+
+// profiling probe - accumulates the cost of all calls of one hot path
+typedef struct
+{
+    const char *name;
+    unsigned long calls;
+    double seconds;
+    unsigned long long cycles;
+} ProfileProbe;
+
+// start of a profiled call
+typedef struct
+{
+    unsigned long long ticks;
+    double time;
+    unsigned long long cycles;
+} ProbeStart;
+
+// latency histogram of one probe - always recorded, in ticks of ReadProbeTicks
+typedef struct
+{
+    unsigned long count;
+    unsigned long long worst;
+    unsigned int buckets[HISTOGRAM_BUCKET_COUNT];
+} LatencyHistogram;
+
+// trace event - begin or end of a probe in ticks of ReadProbeTicks
+typedef struct
+{
+    unsigned long long ticks;
+    int probe;
+    char phase;
+} TraceEvent;
+
+// published statistic of a probe
+typedef struct
+{
+    int probe;
+    int statistic;
+    XPLMDataRef dataRef;
+} PerfDataRef;
+
+// watch table array - all arrays listed in watchArrays grow together with the watch table
+typedef struct
+{
+    void **array;
+    size_t elementSize;
+} WatchArray;
+
+// define watch table growth granularity - always a multiple of the 32 entries covered by one changed-mask word
+#define WATCH_CAPACITY_STEP 32
+
+// change-detection kernel type - sets bit i of changedMask if keys[i] != lastKeys[i]
+typedef void (*DiffKernel)(const int *keys, const int *lastKeys, int count, unsigned int *changedMask);
+
+// wrap kernel type - wraps values[i] into [mins[i], mins[i] + ranges[i]) in place
+typedef void (*WrapKernel)(float *values, const float *mins, const float *ranges, int count);
+
+// global watch table variables - each watched dataref occupies the same index in all arrays
+static int watchCount = 0, watchCapacity = 0, watchPrimed = 0;
+static XPLMDataRef *watchDataRefs = NULL;
+static float *watchValues = NULL, *watchLastValues = NULL, *watchQuanta = NULL, *watchWrapMins = NULL, *watchWrapRanges = NULL;
+static int *watchQuantumSteps = NULL, *watchLastKeys = NULL, *watchKinds = NULL, *watchTypes = NULL, *watchElements = NULL, *watchIntervals = NULL, *watchNext = NULL;
+static unsigned int *watchChangedMask = NULL;
+
+// global alias variables - watchAliasPrimary holds the pilot entry of a copilot entry or -1 and watchAliasSecondary the copilot entry of a pilot entry or -1, state and number of matching changes are kept per copilot entry, which is polled along with its pilot entry and only has its own place in the timing wheel once it is independent
+static int *watchAliasPrimary = NULL, *watchAliasSecondary = NULL, *watchAliasStates = NULL, *watchAliasMatches = NULL;
+
+// global noise filter variables - watchSmoothed holds the moving average, watchHeld the last value that moved past the hysteresis, watchPendingKeys holds the key of a pending change and watchPendingPolls counts how long it has stayed the same
+static float *watchSmoothing = NULL, *watchHysteresis = NULL, *watchSmoothed = NULL, *watchHeld = NULL;
+static int *watchFiltered = NULL, *watchDebounce = NULL, *watchPendingKeys = NULL, *watchPendingPolls = NULL;
+
+// global watch name variables - the dataref name of each entry is kept in one growing pool at the entry's offset
+static int *watchNameOffsets = NULL;
+static char *watchNamePool = NULL;
+static int watchNamePoolLength = 0, watchNamePoolCapacity = 0;
+
+// raw value of each entry that was last written to the session file - it starts at 0 like the datarefs a replay creates, so only reads of other values are written
+static float *watchRecordedValues = NULL;
+
+// governor state of each entry - entries whose reads were too expensive are dropped until the governor recovers
+static int *watchDropped = NULL;
+static int droppedWatchCount = 0;
+
+// global due entry variables - the entries polled in the current tick are packed into these arrays, watchValues holds their new values
+static int *watchDueIndices = NULL;
+static int *watchDueKeys = NULL, *watchDueLastKeys = NULL;
+static float *watchDueWrapMins = NULL, *watchDueWrapRanges = NULL;
+
+// global timing wheel variables - each slot is the head of a list of entries linked through watchNext and remembers its last entry, inputEpoch counts mouse input and watchEpochs holds the count an entry was last polled at
+static int wheelSlots[WHEEL_SLOT_COUNT], wheelTails[WHEEL_SLOT_COUNT];
+static unsigned int wheelTick = 0, inputEpoch = 0;
+static unsigned int *watchEpochs = NULL;
+
+// global scan variables - the entries of a tick that do not fit into the scan budget are scanned in the following frames, so are the entries whose baseline was not taken yet after polling woke up
+static int scanPosition = 0, scanCount = 0, scanChangedIndex = -1, baselinePosition = 0;
+static float scanChangedValue = 0.0f, scanTickTime = 0.0f, worstScanLatency = 0.0f;
+static double scanBudget = SCAN_BUDGET;
+static DiffKernel diffKernel = NULL;
+static WrapKernel wrapKernel = NULL;
+
+// global table of all per-entry watch arrays, the changed mask holds one bit per entry and is handled separately
+static WatchArray watchArrays[] = {{(void**) &watchDataRefs, sizeof(XPLMDataRef)}, {(void**) &watchValues, sizeof(float)}, {(void**) &watchLastValues, sizeof(float)}, {(void**) &watchQuanta, sizeof(float)}, {(void**) &watchQuantumSteps, sizeof(int)}, {(void**) &watchWrapMins, sizeof(float)}, {(void**) &watchWrapRanges, sizeof(float)}, {(void**) &watchLastKeys, sizeof(int)}, {(void**) &watchKinds, sizeof(int)}, {(void**) &watchTypes, sizeof(int)}, {(void**) &watchElements, sizeof(int)}, {(void**) &watchIntervals, sizeof(int)}, {(void**) &watchNext, sizeof(int)}, {(void**) &watchEpochs, sizeof(unsigned int)}, {(void**) &watchDueIndices, sizeof(int)}, {(void**) &watchDueKeys, sizeof(int)}, {(void**) &watchDueLastKeys, sizeof(int)}, {(void**) &watchDueWrapMins, sizeof(float)}, {(void**) &watchDueWrapRanges, sizeof(float)}, {(void**) &watchAliasPrimary, sizeof(int)}, {(void**) &watchAliasSecondary, sizeof(int)}, {(void**) &watchAliasStates, sizeof(int)}, {(void**) &watchAliasMatches, sizeof(int)}, {(void**) &watchSmoothing, sizeof(float)}, {(void**) &watchHysteresis, sizeof(float)}, {(void**) &watchSmoothed, sizeof(float)}, {(void**) &watchHeld, sizeof(float)}, {(void**) &watchFiltered, sizeof(int)}, {(void**) &watchDebounce, sizeof(int)}, {(void**) &watchPendingKeys, sizeof(int)}, {(void**) &watchPendingPolls, sizeof(int)}, {(void**) &watchDropped, sizeof(int)}, {(void**) &watchNameOffsets, sizeof(int)}, {(void**) &watchRecordedValues, sizeof(float)}};
+
+// global internal variables
+static char hintText[HINT_TEXT_LENGTH] = "";
+static int bringFakeWindowToFront = 0, fakeWindowWidth = 0, fakeWindowHeight = 0, lastChangeDetected = 0, forceDisplay = 0;
+static float lastInputTime = 0.0f, lastHintTime = 0.0f, pollBurstEndTime = 0.0f;
+static int drawCallbackRegistered = 0, hintVisible = 0;
+
+// global hint variables - the current hint is kept as kind and raw value and only formatted into hintText when it is drawn, hintFormatted tells if hintText still matches them
+static int hintKind = WATCH_KIND_DRIFT, hintFormatted = 1;
+static float hintValue = 0.0f;
+
+// global glyph atlas variables - the hint text is laid out into a quad vertex buffer only when it changes
+static const char glyphCharacters[] = " -./0123456789HMbdefghikmntz";
+static const unsigned char glyphRows[][GLYPH_HEIGHT] =
+{
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00}, // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c}, // '.'
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // '/'
+    {0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e}, // '0'
+    {0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e}, // '1'
+    {0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f}, // '2'
+    {0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e}, // '3'
+    {0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02}, // '4'
+    {0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e}, // '5'
+    {0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e}, // '6'
+    {0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // '7'
+    {0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e}, // '8'
+    {0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c}, // '9'
+    {0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11}, // 'H'
+    {0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11}, // 'M'
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1e}, // 'b'
+    {0x01, 0x01, 0x0d, 0x13, 0x11, 0x11, 0x0f}, // 'd'
+    {0x00, 0x00, 0x0e, 0x11, 0x1f, 0x10, 0x0e}, // 'e'
+    {0x06, 0x09, 0x08, 0x1c, 0x08, 0x08, 0x08}, // 'f'
+    {0x00, 0x0f, 0x11, 0x11, 0x0f, 0x01, 0x0e}, // 'g'
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11}, // 'h'
+    {0x04, 0x00, 0x0c, 0x04, 0x04, 0x04, 0x0e}, // 'i'
+    {0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12}, // 'k'
+    {0x00, 0x00, 0x1a, 0x15, 0x15, 0x11, 0x11}, // 'm'
+    {0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11}, // 'n'
+    {0x08, 0x08, 0x1c, 0x08, 0x08, 0x09, 0x06}, // 't'
+    {0x00, 0x00, 0x1f, 0x02, 0x04, 0x08, 0x1f}  // 'z'
+};
+static int glyphAtlasTexture = 0, hintLayoutDirty = 1, hintVertexCount = -1;
+static float hintVertices[HINT_TEXT_LENGTH * 8], hintTexCoords[HINT_TEXT_LENGTH * 8];
+static unsigned long drawCallbackCalls = 0;
+static XPLMWindowID fakeWindow = NULL;
+
+// global file variables
+static char pluginPath[512] = "";
+static FILE *sessionFile = NULL;
+
+// global command binding variables - commandWatchIndices holds the watch table entries that wait for their one-shot read
+static CommandBinding commandBindings[MAX_COMMAND_BINDINGS];
+static int commandBindingCount = 0, commandWatchCount = 0;
+static int commandWatchIndices[MAX_COMMAND_BINDINGS];
+
+// global suppression rule variables
+static SuppressionRule suppressionRules[MAX_SUPPRESSION_RULES];
+static int suppressionRuleCount = 0, suppressedKinds = 0;
+
+// global noise filter rule variables - the rules are applied to the watch table once all watches are added
+static FilterRule filterRules[MAX_FILTER_RULES];
+static int filterRuleCount = 0;
+
+// global pending config line variables - watch, command and filter lines that named a dataref or command the running sim did not have yet, they are parsed again after every plane load
+static char pendingLines[MAX_PENDING_LINES][512];
+static int pendingLineCount = 0;
+
+// global scheduler variables
+static XPLMFlightLoopID schedulerFlightLoop = NULL;
+static SchedulerTask schedulerTasks[TASK_COUNT];
+static float taskDeadlines[TASK_COUNT];
+static int taskActive[TASK_COUNT], schedulerFirstTask = 0, schedulerRunning = 0;
+
+// global profiling variables
+static int profiling = 0;
+static unsigned long allocations = 0;
+static ProfileProbe profileProbes[PROBE_COUNT] = {{"update_fake_window"}, {"poll_watches"}, {"update_hint"}, {"read_command_watches"}, {"draw"}, {"display_hint"}, {"mouse_input"}, {"flight_loop"}};
+
+// global latency histogram variables - the calibration point converts time stamp counter ticks to nanoseconds when a statistic is read
+static LatencyHistogram probeHistograms[PROBE_COUNT];
+static PerfDataRef perfDataRefs[PROBE_COUNT * PERF_STATISTIC_COUNT];
+static XPLMDataRef worstScanLatencyDataRef = NULL;
+static const char *perfStatisticNames[PERF_STATISTIC_COUNT] = {"count", "p50_ns", "p90_ns", "p99_ns", "p999_ns", "worst_ns"};
+static unsigned long long calibrationTicks = 0;
+static double calibrationTime = 0.0;
+
+// global tracing variables - the sim thread is the only one that calls into the plugin, it appends to the ring buffer at traceHead while the flush thread consumes it from traceTail, neither ever waits for the other
+static int tracing = 0;
+static TraceEvent *traceEvents = NULL;
+static unsigned int traceHead = 0, traceTail = 0, traceStopping = 0;
+static unsigned long traceWritten = 0, traceDropped = 0;
+static FILE *traceFile = NULL;
+#if IBM
+static HANDLE traceThread = NULL;
+#else
+static pthread_t traceThread;
+#endif
+
+// sim time of the current scheduler pass or input event - all plugin logic uses this instead of reading the sim clock on its own, so its behavior only depends on the sequence of elapsed times the host reports
+static float frameTime = 0.0f;
+
+// global governor variables
+static double frameBudget = GOVERNOR_BUDGET;
+static unsigned long long governorTicks = 0, governorWorstTicks = 0, expensiveReadTicks = 0;
+static int governorLevel = GOVERNOR_FULL_OPERATION, governorOverruns = 0, governorRecovered = 0, governorCycle = 0;
+static float governorTransitionTime = 0.0f, governorOverrunTime = 0.0f, governorCalmTime = 0.0f, governorRecoveryTime = GOVERNOR_RECOVERY_TIME;
+static const char *governorLevelNames[GOVERNOR_LEVEL_COUNT] = {"full operation", "reduced poll rate", "expensive watches dropped", "drawing suspended"};
+
+// return a monotonic timestamp in seconds that is cheap to obtain and much finer than the sim's elapsed time
+static double GetMonotonicTime(void)
+{
+#if IBM
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#elif APL
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0)
+        mach_timebase_info(&timebase);
+    return (double) mach_absolute_time() * timebase.numer / timebase.denom * 1.0e-9;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1.0e-9;
+#endif
+}
+
+// return the CPU's time stamp counter or 0 if it cannot be read
+static unsigned long long ReadCycleCounter(void)
+{
+#ifdef WATCH_SIMD
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// return the timestamp latency histograms are recorded in - the time stamp counter where it exists, it is far cheaper to read than the system clock, nanoseconds otherwise
+static unsigned long long ReadProbeTicks(void)
+{
+#ifdef WATCH_SIMD
+    return __rdtsc();
+#else
+    return (unsigned long long) (GetMonotonicTime() * 1.0e9);
+#endif
+}
+
+// return the number of probe ticks per second, measured against the system clock since the plugin started
+static double GetProbeTicksPerSecond(void)
+{
+#ifdef WATCH_SIMD
+    double elapsed = GetMonotonicTime() - calibrationTime;
+    if (elapsed > 0.0)
+        return (double) (ReadProbeTicks() - calibrationTicks) / elapsed;
+#endif
+
+    return 1.0e9;
+}
+
+// return the index of the highest set bit of a non-zero value
+static int GetHighestBit(unsigned long long value)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (int) index;
+#elif defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int index = 0;
+    while ((value >>= 1) != 0)
+        index++;
+    return index;
+#endif
+}
+
+// add a latency to a histogram
+static void AddLatency(LatencyHistogram *histogram, unsigned long long ticks)
+{
+    int bucket = (int) ticks;
+    if (ticks >= (1u << HISTOGRAM_SUB_BITS))
+    {
+        int shift = GetHighestBit(ticks) - HISTOGRAM_SUB_BITS;
+        bucket = ((shift + 1) << HISTOGRAM_SUB_BITS) + (int) ((ticks >> shift) & ((1u << HISTOGRAM_SUB_BITS) - 1));
+    }
+
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    if (ticks > histogram->worst)
+        histogram->worst = ticks;
+}
+
+// return the largest latency in ticks that falls into the given bucket
+static unsigned long long GetBucketLimit(int bucket)
+{
+    if (bucket < (1 << HISTOGRAM_SUB_BITS))
+        return (unsigned long long) bucket;
+
+    int shift = (bucket >> HISTOGRAM_SUB_BITS) - 1;
+    unsigned long long lower = (unsigned long long) ((1 << HISTOGRAM_SUB_BITS) + (bucket & ((1 << HISTOGRAM_SUB_BITS) - 1))) << shift;
+    return lower + ((1ull << shift) - 1);
+}
+
+// return the latency in ticks below which the given fraction of all recorded latencies lies - reported as the upper limit of its bucket, but never above the worst latency
+static unsigned long long GetPercentile(const LatencyHistogram *histogram, double fraction)
+{
+    if (histogram->count == 0)
+        return 0;
+
+    unsigned long long rank = (unsigned long long) ceil(fraction * histogram->count), seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= rank)
+        {
+            unsigned long long limit = GetBucketLimit(i);
+            return limit < histogram->worst ? limit : histogram->worst;
+        }
+    }
+
+    return histogram->worst;
+}
+
+// dataref read callback of the count statistic
+static int GetPerfCount(void *inRefcon)
+{
+    return (int) probeHistograms[((PerfDataRef*) inRefcon)->probe].count;
+}
+
+// dataref read callback of the latency statistics
+static float GetPerfLatency(void *inRefcon)
+{
+    static const double fractions[PERF_STATISTIC_COUNT] = {0.0, 0.5, 0.9, 0.99, 0.999, 1.0};
+    const PerfDataRef *perfDataRef = (PerfDataRef*) inRefcon;
+    const LatencyHistogram *histogram = &probeHistograms[perfDataRef->probe];
+
+    unsigned long long ticks = perfDataRef->statistic == PERF_WORST ? histogram->worst : GetPercentile(histogram, fractions[perfDataRef->statistic]);
+    return (float) (ticks * 1.0e9 / GetProbeTicksPerSecond());
+}
+
+// dataref read callback of the worst time between a tick and the frame its last entries are scanned in
+static float GetWorstScanLatency(void *inRefcon)
+{
+    return worstScanLatency * 1.0e9f;
+}
+
+// publish the statistics of all probes and the worst scan latency as read-only datarefs - the histograms start empty
+static void RegisterPerfDataRefs(void)
+{
+    memset(probeHistograms, 0, sizeof(probeHistograms));
+    calibrationTicks = ReadProbeTicks();
+    calibrationTime = GetMonotonicTime();
+
+    for (int i = 0; i < PROBE_COUNT * PERF_STATISTIC_COUNT; i++)
+    {
+        PerfDataRef *perfDataRef = &perfDataRefs[i];
+        perfDataRef->probe = i / PERF_STATISTIC_COUNT;
+        perfDataRef->statistic = i % PERF_STATISTIC_COUNT;
+
+        char name[128];
+        sprintf(name, NAME_LOWERCASE "/perf/%s/%s", profileProbes[perfDataRef->probe].name, perfStatisticNames[perfDataRef->statistic]);
+
+        if (perfDataRef->statistic == PERF_COUNT)
+            perfDataRef->dataRef = XPLMRegisterDataAccessor(name, xplmType_Int, 0, GetPerfCount, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, perfDataRef, NULL);
+        else
+            perfDataRef->dataRef = XPLMRegisterDataAccessor(name, xplmType_Float, 0, NULL, NULL, GetPerfLatency, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, perfDataRef, NULL);
+    }
+
+    worstScanLatencyDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/perf/worst_scan_latency_ns", xplmType_Float, 0, NULL, NULL, GetWorstScanLatency, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+}
+
+// withdraw the perf datarefs
+static void UnregisterPerfDataRefs(void)
+{
+    for (int i = 0; i < PROBE_COUNT * PERF_STATISTIC_COUNT; i++)
+    {
+        if (perfDataRefs[i].dataRef != NULL)
+        {
+            XPLMUnregisterDataAccessor(perfDataRefs[i].dataRef);
+            perfDataRefs[i].dataRef = NULL;
+        }
+    }
+
+    if (worstScanLatencyDataRef != NULL)
+    {
+        XPLMUnregisterDataAccessor(worstScanLatencyDataRef);
+        worstScanLatencyDataRef = NULL;
+    }
+}
+
+// append an event to the trace ring buffer - it is dropped if the buffer is full
+static void AddTraceEvent(char phase, int probe, unsigned long long ticks)
+{
+    unsigned int head = traceHead;
+    if (head - LOAD_ACQUIRE(&traceTail) == TRACE_BUFFER_SIZE)
+    {
+        traceDropped++;
+        return;
+    }
+
+    TraceEvent *event = &traceEvents[head & (TRACE_BUFFER_SIZE - 1)];
+    event->ticks = ticks;
+    event->probe = probe;
+    event->phase = phase;
+    STORE_RELEASE(&traceHead, head + 1);
+}
+
+// write all events the sim thread added since the last call to the trace file - only called by the flush thread and after it has ended
+static void FlushTrace(void)
+{
+    unsigned int tail = traceTail, head = LOAD_ACQUIRE(&traceHead);
+    double ticksPerMicrosecond = GetProbeTicksPerSecond() * 1.0e-6;
+
+    for (; tail != head; tail++)
+    {
+        const TraceEvent *event = &traceEvents[tail & (TRACE_BUFFER_SIZE - 1)];
+        fprintf(traceFile, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":1}", profileProbes[event->probe].name, event->phase, (double) (event->ticks - calibrationTicks) / ticksPerMicrosecond);
+        traceWritten++;
+    }
+
+    STORE_RELEASE(&traceTail, tail);
+    fflush(traceFile);
+}
+
+// flush thread - writes the ring buffer to the trace file until tracing stops
+#if IBM
+static DWORD WINAPI TraceThread(LPVOID parameter)
+#else
+static void *TraceThread(void *parameter)
+#endif
+{
+    while (LOAD_ACQUIRE(&traceStopping) == 0)
+    {
+        FlushTrace();
+#if IBM
+        Sleep(TRACE_FLUSH_INTERVAL);
+#else
+        struct timespec interval = {0, TRACE_FLUSH_INTERVAL * 1000000L};
+        nanosleep(&interval, NULL);
+#endif
+    }
+
+    return 0;
+}
+
+// start writing begin and end events of all probes to a Chrome trace file in X-Plane's output folder
+static void StartTracing(void)
+{
+    if (tracing != 0)
+        return;
+
+    char fileName[64], path[1024];
+    time_t now = time(NULL);
+    strftime(fileName, sizeof(fileName), NAME_LOWERCASE "_trace_%Y%m%d_%H%M%S.json", localtime(&now));
+    XPLMGetSystemPath(path);
+    snprintf(path + strlen(path), sizeof(path) - strlen(path), "Output%s%s", XPLMGetDirectorySeparator(), fileName);
+
+    traceEvents = (TraceEvent*) malloc(TRACE_BUFFER_SIZE * sizeof(TraceEvent));
+    allocations++;
+    traceFile = traceEvents != NULL ? fopen(path, "w") : NULL;
+    if (traceFile == NULL)
+    {
+        XPLMDebugString(NAME ": could not create trace file\n");
+        free(traceEvents);
+        traceEvents = NULL;
+        return;
+    }
+
+    // the metadata event names the only thread, every further event is written with a leading comma
+    fprintf(traceFile, "{\"traceEvents\":[\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"sim\"}}");
+
+    traceHead = 0;
+    traceTail = 0;
+    traceStopping = 0;
+    traceWritten = 0;
+    traceDropped = 0;
+
+#if IBM
+    traceThread = CreateThread(NULL, 0, TraceThread, NULL, 0, NULL);
+    int started = traceThread != NULL;
+#else
+    int started = pthread_create(&traceThread, NULL, TraceThread, NULL) == 0;
+#endif
+    if (started == 0)
+    {
+        XPLMDebugString(NAME ": could not start trace thread\n");
+        fclose(traceFile);
+        traceFile = NULL;
+        free(traceEvents);
+        traceEvents = NULL;
+        return;
+    }
+
+    tracing = 1;
+
+    char message[1100];
+    snprintf(message, sizeof(message), NAME ": tracing to %s\n", path);
+    XPLMDebugString(message);
+}
+
+// stop the flush thread, write the remaining events and close the trace file
+static void StopTracing(void)
+{
+    if (tracing == 0)
+        return;
+
+    tracing = 0;
+    STORE_RELEASE(&traceStopping, 1);
+#if IBM
+    WaitForSingleObject(traceThread, INFINITE);
+    CloseHandle(traceThread);
+    traceThread = NULL;
+#else
+    pthread_join(traceThread, NULL);
+#endif
+
+    FlushTrace();
+    fprintf(traceFile, "\n]}\n");
+    fclose(traceFile);
+    traceFile = NULL;
+    free(traceEvents);
+    traceEvents = NULL;
+
+    char message[128];
+    sprintf(message, NAME ": wrote %lu trace events, dropped %lu\n", traceWritten, traceDropped);
+    XPLMDebugString(message);
+}
+
+// close the frame the governor counts the plugin's cost in once the sim started a new one - the cost of the closed frame is a candidate for the worst frame since the last scheduler pass
+static void CloseGovernorFrame(void)
+{
+    int cycle = XPLMGetCycleNumber();
+    if (cycle == governorCycle)
+        return;
+
+    if (governorTicks > governorWorstTicks)
+        governorWorstTicks = governorTicks;
+    governorTicks = 0;
+    governorCycle = cycle;
+}
+
+// add the cost of a call to the plugin's cost in the current frame
+static void AddFrameTicks(unsigned long long ticks)
+{
+    CloseGovernorFrame();
+    governorTicks += ticks;
+}
+
+// remember when a profiled call started - the latency histograms are always fed, the trace and the profile only if they are on
+static void BeginProbe(int probe, ProbeStart *start)
+{
+    start->ticks = ReadProbeTicks();
+    if (tracing != 0)
+        AddTraceEvent('B', probe, start->ticks);
+
+    if (profiling != 0)
+    {
+        start->time = GetMonotonicTime();
+        start->cycles = ReadCycleCounter();
+    }
+    else
+    {
+        start->time = 0.0;
+        start->cycles = 0;
+    }
+}
+
+// add the cost of a profiled call to its probe
+static void EndProbe(int probe, const ProbeStart *start)
+{
+    unsigned long long ticks = ReadProbeTicks();
+    AddLatency(&probeHistograms[probe], ticks - start->ticks);
+    if (probe == PROBE_FLIGHT_LOOP || probe == PROBE_DRAW || probe == PROBE_MOUSE_INPUT)
+        AddFrameTicks(ticks - start->ticks);
+    if (tracing != 0)
+        AddTraceEvent('E', probe, ticks);
+
+    if (profiling != 0)
+    {
+        profileProbes[probe].calls++;
+        profileProbes[probe].cycles += ReadCycleCounter() - start->cycles;
+        profileProbes[probe].seconds += GetMonotonicTime() - start->time;
+    }
+}
+
+// determine the plugin's folder by stripping the file name and the 32 / 64 bit folder from the path of the plugin binary
+static void ResolvePluginPath(void)
+{
+    XPLMGetPluginInfo(XPLMGetMyID(), NULL, pluginPath, NULL, NULL);
+
+    char separator = XPLMGetDirectorySeparator()[0];
+    char *end = strrchr(pluginPath, separator);
+    if (end != NULL)
+        *end = '\0';
+    end = strrchr(pluginPath, separator);
+    if (end != NULL && (strcmp(end + 1, "32") == 0 || strcmp(end + 1, "64") == 0))
+        *end = '\0';
+}
+
+// build the path of a file in the plugin's folder
+static void GetPluginFilePath(char *path, size_t size, const char *fileName)
+{
+    snprintf(path, size, "%s%c%s", pluginPath, XPLMGetDirectorySeparator()[0], fileName);
+}
+
+// write raw bytes to the session file
+static void WriteSession(const void *data, size_t size)
+{
+    fwrite(data, size, 1, sessionFile);
+}
+
+// write a record type and the current frame time to the session file
+static void WriteSessionRecordHeader(char type)
+{
+    WriteSession(&type, sizeof(type));
+    WriteSession(&frameTime, sizeof(frameTime));
+}
+
+// open a new session file in the plugin's folder that records all watched values, mouse input and hints of this session
+static void StartRecording(void)
+{
+    if (sessionFile != NULL)
+        return;
+
+    char fileName[64], path[1024];
+    time_t now = time(NULL);
+    strftime(fileName, sizeof(fileName), NAME_LOWERCASE "_%Y%m%d_%H%M%S.rec", localtime(&now));
+    GetPluginFilePath(path, sizeof(path), fileName);
+
+    sessionFile = fopen(path, "wb");
+    if (sessionFile == NULL)
+    {
+        XPLMDebugString(NAME ": could not create session file\n");
+        return;
+    }
+    setvbuf(sessionFile, NULL, _IOFBF, SESSION_BUFFER_SIZE);
+
+    int version = SESSION_VERSION;
+    WriteSession(SESSION_MAGIC, strlen(SESSION_MAGIC));
+    WriteSession(&version, sizeof(version));
+
+    char message[1100];
+    snprintf(message, sizeof(message), NAME ": recording session to %s\n", path);
+    XPLMDebugString(message);
+}
+
+// flush and close the session file
+static void StopRecording(void)
+{
+    if (sessionFile == NULL)
+        return;
+
+    fclose(sessionFile);
+    sessionFile = NULL;
+}
+
+// return the dataref name an entry was added with
+static const char *GetWatchName(int index)
+{
+    return watchNamePool + watchNameOffsets[index];
+}
+
+// record the entries from the given one on with their dataref name and every parameter that decides how they are read, filtered and displayed - the index of an entry is the number of watch records before it
+static void RecordWatches(int first)
+{
+    for (int i = first; i < watchCount; i++)
+    {
+        const char *name = GetWatchName(i);
+        char type = SESSION_RECORD_WATCH;
+        unsigned short length = (unsigned short) strlen(name);
+        unsigned char kind = (unsigned char) watchKinds[i];
+        WriteSession(&type, sizeof(type));
+        WriteSession(&length, sizeof(length));
+        WriteSession(name, length);
+        WriteSession(&kind, sizeof(kind));
+        WriteSession(&watchTypes[i], sizeof(int));
+        WriteSession(&watchQuanta[i], sizeof(float));
+        WriteSession(&watchWrapMins[i], sizeof(float));
+        WriteSession(&watchWrapRanges[i], sizeof(float));
+        WriteSession(&watchSmoothing[i], sizeof(float));
+        WriteSession(&watchHysteresis[i], sizeof(float));
+        WriteSession(&watchDebounce[i], sizeof(int));
+        WriteSession(&watchAliasPrimary[i], sizeof(int));
+    }
+}
+
+// record the command bindings from the given one on with the name of the command and the entry it reads
+static void RecordCommandBindings(int first)
+{
+    for (int i = first; i < commandBindingCount; i++)
+    {
+        char type = SESSION_RECORD_COMMAND;
+        unsigned short length = (unsigned short) strlen(commandBindings[i].commandName);
+        unsigned int index = (unsigned int) commandBindings[i].watchIndex;
+        WriteSession(&type, sizeof(type));
+        WriteSession(&length, sizeof(length));
+        WriteSession(commandBindings[i].commandName, length);
+        WriteSession(&index, sizeof(index));
+    }
+}
+
+// record the raw value a read of an entry returned - before wrapping and filtering and only if it differs in any bit from the last recorded value of the entry
+static void RecordValue(int index, float value)
+{
+    if (memcmp(&value, &watchRecordedValues[index], sizeof(float)) == 0)
+        return;
+
+    char type = SESSION_RECORD_VALUE;
+    unsigned int entry = (unsigned int) index;
+    WriteSession(&type, sizeof(type));
+    WriteSession(&entry, sizeof(entry));
+    WriteSession(&value, sizeof(value));
+    watchRecordedValues[index] = value;
+}
+
+// record the hint kinds that enabled plugins suppress
+static void RecordSuppression(void)
+{
+    char type = SESSION_RECORD_SUPPRESSION;
+    WriteSession(&type, sizeof(type));
+    WriteSession(&suppressedKinds, sizeof(suppressedKinds));
+}
+
+// record the noise filter parameters an entry that is already described in the session file has now
+static void RecordFilter(int index)
+{
+    char type = SESSION_RECORD_FILTER;
+    unsigned int entry = (unsigned int) index;
+    WriteSession(&type, sizeof(type));
+    WriteSession(&entry, sizeof(entry));
+    WriteSession(&watchSmoothing[index], sizeof(float));
+    WriteSession(&watchHysteresis[index], sizeof(float));
+    WriteSession(&watchDebounce[index], sizeof(int));
+}
+
+// record a phase of a bound command with the entry the command reads
+static void RecordCommand(int index, XPLMCommandPhase phase)
+{
+    int arguments[] = {index, phase};
+    WriteSessionRecordHeader(SESSION_RECORD_COMMAND_PHASE);
+    WriteSession(arguments, sizeof(arguments));
+}
+
+// record a mouse click or wheel event with its arguments
+static void RecordMouse(char type, int x, int y, int a, int b)
+{
+    int arguments[] = {x, y, a, b};
+    WriteSessionRecordHeader(type);
+    WriteSession(arguments, sizeof(arguments));
+}
+
+// record the text of a hint that was shown
+static void RecordHint(void)
+{
+    unsigned char length = (unsigned char) strlen(hintText);
+    WriteSessionRecordHeader(SESSION_RECORD_HINT);
+    WriteSession(&length, sizeof(length));
+    WriteSession(hintText, length);
+}
+
+// return the interval after which the scheduler flight loop has to run again
+static float GetSchedulerInterval(float currentTime)
+{
+    float interval = 0.0f;
+
+    for (int i = 0; i < TASK_COUNT; i++)
+    {
+        if (taskActive[i] == 0)
+            continue;
+
+        float remaining = taskDeadlines[i] - currentTime;
+        if (remaining <= 0.0f)
+            return -1.0f;
+
+        if (interval == 0.0f || remaining < interval)
+            interval = remaining;
+    }
+
+    return interval;
+}
+
+// set the deadline of a task from an interval in flightloop-callback format
+static void SetTaskDeadline(int task, float interval, float currentTime)
+{
+    taskActive[task] = interval != 0.0f;
+    taskDeadlines[task] = interval > 0.0f ? currentTime + interval : currentTime;
+}
+
+// (re)schedule a task to run after the given interval, waking up the scheduler if necessary
+static void ScheduleTask(int task, float interval)
+{
+    // while the scheduler is running its return value takes care of rescheduling
+    if (schedulerRunning != 0)
+    {
+        SetTaskDeadline(task, interval, frameTime);
+        return;
+    }
+
+    frameTime = XPLMGetElapsedTime();
+    SetTaskDeadline(task, interval, frameTime);
+
+    if (schedulerFlightLoop != NULL)
+        XPLMScheduleFlightLoop(schedulerFlightLoop, GetSchedulerInterval(frameTime), 1);
+}
+
+// switch the governor to another level and log the transition
+static void SetGovernorLevel(int level, double cost, float currentTime)
+{
+    char message[192];
+    sprintf(message, NAME ": governor %s -> %s, frame cost %.0f us, budget %.0f us\n", governorLevelNames[governorLevel], governorLevelNames[level], cost * 1.0e6, frameBudget * 1.0e6);
+    XPLMDebugString(message);
+
+    // stepping down again soon after a recovery doubles the time the next recovery takes, so a dataref that stays slow cannot cause periodic stutters
+    if (level > governorLevel)
+    {
+        if (governorRecovered != 0 && currentTime - governorTransitionTime < governorRecoveryTime * 2.0f)
+            governorRecoveryTime = governorRecoveryTime * 2.0f < GOVERNOR_MAX_RECOVERY_TIME ? governorRecoveryTime * 2.0f : GOVERNOR_MAX_RECOVERY_TIME;
+        else if (governorLevel == GOVERNOR_FULL_OPERATION)
+            governorRecoveryTime = GOVERNOR_RECOVERY_TIME;
+    }
+    governorRecovered = level < governorLevel;
+
+    // the hint task registers or unregisters the draw-callback according to the new level
+    if ((governorLevel >= GOVERNOR_SUSPEND_DRAWING) != (level >= GOVERNOR_SUSPEND_DRAWING))
+        ScheduleTask(TASK_UPDATE_HINT, -1.0f);
+
+    governorLevel = level;
+    governorOverruns = 0;
+    governorTransitionTime = currentTime;
+    governorCalmTime = currentTime;
+}
+
+// compare the plugin's own cost in the worst frame since the last scheduler pass against the frame budget - a frame's cost is the scheduler pass that ran in it plus the draw callback and the input handlers of that frame, step down a level if the budget is exceeded repeatedly and back up once it stayed well below for a while
+static void UpdateGovernor(float currentTime)
+{
+    // the frame this pass runs in is judged at the next pass, once its cost is complete
+    CloseGovernorFrame();
+    unsigned long long ticks = governorWorstTicks;
+    governorWorstTicks = 0;
+
+    // the read cost above which the governor drops a watch is kept in probe ticks, so reads are only compared against it
+    double ticksPerSecond = GetProbeTicksPerSecond();
+    expensiveReadTicks = (unsigned long long) (frameBudget * GOVERNOR_EXPENSIVE_SHARE * ticksPerSecond);
+
+    if (frameBudget <= 0.0)
+        return;
+
+    double cost = (double) ticks / ticksPerSecond;
+    if (cost > frameBudget)
+    {
+        governorCalmTime = currentTime;
+        if (currentTime - governorOverrunTime > GOVERNOR_OVERRUN_WINDOW)
+        {
+            governorOverruns = 0;
+            governorOverrunTime = currentTime;
+        }
+
+        if (++governorOverruns >= GOVERNOR_OVERRUN_FRAMES && governorLevel < GOVERNOR_LEVEL_COUNT - 1 && currentTime - governorTransitionTime >= GOVERNOR_SETTLE_TIME)
+            SetGovernorLevel(governorLevel + 1, cost, currentTime);
+        return;
+    }
+
+    if (cost > frameBudget * GOVERNOR_RECOVERY_SHARE)
+        governorCalmTime = currentTime;
+    else if (governorLevel > GOVERNOR_FULL_OPERATION && currentTime - governorCalmTime >= governorRecoveryTime)
+        SetGovernorLevel(governorLevel - 1, cost, currentTime);
+}
+
+// return the interval at which the watched datarefs are polled at the current governor level
+static float GetPollInterval(void)
+{
+    return governorLevel >= GOVERNOR_REDUCE_POLL_RATE ? POLL_INTERVAL * GOVERNOR_POLL_FACTOR : POLL_INTERVAL;
+}
+
+// flightloop-callback that runs all due tasks within the plugin-wide time budget
+static float SchedulerCallback(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void *inRefcon)
+{
+    ProbeStart loopProbeStart;
+    BeginProbe(PROBE_FLIGHT_LOOP, &loopProbeStart);
+
+    frameTime = XPLMGetElapsedTime();
+    float currentTime = frameTime;
+    double startTime = GetMonotonicTime();
+    int tasksRun = 0;
+
+    if (sessionFile != NULL)
+        WriteSessionRecordHeader(SESSION_RECORD_FRAME);
+
+    USDT_PROBE1(flight_loop_entry, currentTime * 1000.0f);
+
+    schedulerRunning = 1;
+
+    UpdateGovernor(currentTime);
+
+    // start with the task that was deferred last so no task can be starved by the budget
+    for (int i = 0; i < TASK_COUNT; i++)
+    {
+        int task = (schedulerFirstTask + i) % TASK_COUNT;
+        if (taskActive[task] == 0 || currentTime < taskDeadlines[task])
+            continue;
+
+        if (tasksRun != 0 && GetMonotonicTime() - startTime > SCHEDULER_BUDGET)
+        {
+            schedulerFirstTask = task;
+            break;
+        }
+
+        ProbeStart probeStart;
+        BeginProbe(task, &probeStart);
+        SetTaskDeadline(task, schedulerTasks[task](currentTime), currentTime);
+        EndProbe(task, &probeStart);
+        tasksRun++;
+    }
+
+    schedulerRunning = 0;
+
+    float interval = GetSchedulerInterval(currentTime);
+    EndProbe(PROBE_FLIGHT_LOOP, &loopProbeStart);
+
+    USDT_PROBE2(flight_loop_exit, tasksRun, interval * 1000000.0f);
+
+    return interval;
+}
+
+// scheduler task that resizes the fake window if the screen size changed and brings it back to the front if needed
+static float UpdateFakeWindowTask(float currentTime)
+{
+    if (fakeWindow != NULL)
+    {
+        int x = 0, y = 0;
+        XPLMGetScreenSize(&x, &y);
+        if (x != fakeWindowWidth || y != fakeWindowHeight)
+        {
+            XPLMSetWindowGeometry(fakeWindow, 0, y, x, 0);
+            fakeWindowWidth = x;
+            fakeWindowHeight = y;
+        }
+
+        if (bringFakeWindowToFront == 0 || XPLMIsWindowInFront(fakeWindow) == 0)
+        {
+            XPLMBringWindowToFront(fakeWindow);
+            bringFakeWindowToFront = 1;
+        }
+    }
+
+    return FAKE_WINDOW_CHECK_INTERVAL;
+}
+
+// check if a plugin with a given signature is enabled
+static int IsPluginEnabled(const char* pluginSignature)
+{
+    XPLMPluginID pluginId = XPLMFindPluginBySignature(pluginSignature);
+
+    return XPLMIsPluginEnabled(pluginId);
+}
+
+// return the watch kind with the given name or -1 if there is no such kind
+static int ParseWatchKind(const char *name)
+{
+    if (strcmp(name, "drift") == 0)
+        return WATCH_KIND_DRIFT;
+    else if (strcmp(name, "heading") == 0)
+        return WATCH_KIND_HEADING;
+    else if (strcmp(name, "barometer") == 0)
+        return WATCH_KIND_BAROMETER;
+    else
+        return -1;
+}
+
+// add a rule that suppresses hints of the given kinds while the plugin with the given signature is enabled
+static void AddSuppressionRule(const char *signature, int kinds)
+{
+    if (suppressionRuleCount == MAX_SUPPRESSION_RULES)
+        return;
+
+    SuppressionRule *rule = &suppressionRules[suppressionRuleCount++];
+    strncpy(rule->signature, signature, sizeof(rule->signature) - 1);
+    rule->signature[sizeof(rule->signature) - 1] = '\0';
+    rule->suppressedKinds = kinds;
+}
+
+// resolve all suppression rules against the currently enabled plugins - only called when the set of loaded plugins may have changed
+static void RefreshSuppressedKinds(void)
+{
+    suppressedKinds = 0;
+
+    for (int i = 0; i < suppressionRuleCount; i++)
+    {
+        if (IsPluginEnabled(suppressionRules[i].signature) != 0)
+            suppressedKinds |= suppressionRules[i].suppressedKinds;
+    }
+
+    if (sessionFile != NULL)
+        RecordSuppression();
+}
+
+// parse the arguments of a config line of the form: suppress <plugin signature> <kind> [<kind> ...]
+static void ParseSuppressionRule(char *arguments)
+{
+    char *signature = strtok(arguments, " \t\r\n");
+    if (signature == NULL)
+        return;
+
+    int kinds = 0;
+    for (char *name = strtok(NULL, " \t\r\n"); name != NULL; name = strtok(NULL, " \t\r\n"))
+    {
+        int kind = ParseWatchKind(name);
+        if (kind < 0)
+        {
+            XPLMDebugString(NAME ": ignoring unknown hint kind in " CONFIG_FILE_NAME "\n");
+            continue;
+        }
+
+        kinds |= WATCH_KIND_BIT(kind);
+    }
+
+    AddSuppressionRule(signature, kinds);
+}
+
+// write the accumulated cost of every probe as CSV to the plugin's folder
+static void WriteProfile(void)
+{
+    char path[1024];
+    GetPluginFilePath(path, sizeof(path), PROFILE_FILE_NAME);
+
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        XPLMDebugString(NAME ": could not create profile file\n");
+        return;
+    }
+
+    fprintf(file, "probe,calls,ns_per_call,cycles_per_call,total_ms\n");
+    for (int i = 0; i < PROBE_COUNT; i++)
+    {
+        const ProfileProbe *probe = &profileProbes[i];
+        double calls = probe->calls != 0 ? (double) probe->calls : 1.0;
+        fprintf(file, "%s,%lu,%.1f,%.1f,%.3f\n", probe->name, probe->calls, probe->seconds * 1.0e9 / calls, (double) probe->cycles / calls, probe->seconds * 1.0e3);
+    }
+    fprintf(file, "allocations,%lu,,,\n", allocations);
+    fprintf(file, "worst_scan_latency,,,,%.3f\n", worstScanLatency * 1.0e3);
+
+    fclose(file);
+}
+
+// wrap a value into [min, min + range) - a range of 0 returns the value as it is, this is the reference all wrap kernels must match bit for bit
+static float WrapValue(float value, float min, float range)
+{
+    float wrapped = value - range * floorf((value - min) / range);
+
+    // rounding may land just below the lower or exactly on the upper bound
+    wrapped = wrapped > min ? wrapped : min;
+    wrapped = wrapped < min + range ? wrapped : min;
+
+    return range > 0.0f ? wrapped : value;
+}
+
+// lay out the given text as one textured quad per character relative to the text origin - only touches the given arrays so it runs without a GL context, returns the number of vertices or -1 if a character has no glyph
+static int LayoutText(const char *text, float *vertices, float *texCoords, int maxCharacters)
+{
+    int vertexCount = 0;
+
+    for (int i = 0; text[i] != '\0'; i++)
+    {
+        const char *glyph = strchr(glyphCharacters, text[i]);
+        if (glyph == NULL || i == maxCharacters)
+            return -1;
+
+        float left = i * GLYPH_CELL_WIDTH * GLYPH_SCALE, right = left + GLYPH_WIDTH * GLYPH_SCALE, top = GLYPH_HEIGHT * GLYPH_SCALE;
+        float u0 = (float) ((glyph - glyphCharacters) * GLYPH_CELL_WIDTH) / GLYPH_ATLAS_WIDTH, u1 = u0 + (float) GLYPH_WIDTH / GLYPH_ATLAS_WIDTH, v1 = (float) GLYPH_HEIGHT / GLYPH_ATLAS_HEIGHT;
+
+        float quadVertices[] = {left, 0.0f, right, 0.0f, right, top, left, top};
+        float quadTexCoords[] = {u0, 0.0f, u1, 0.0f, u1, v1, u0, v1};
+        memcpy(vertices + vertexCount * 2, quadVertices, sizeof(quadVertices));
+        memcpy(texCoords + vertexCount * 2, quadTexCoords, sizeof(quadTexCoords));
+        vertexCount += 4;
+    }
+
+    return vertexCount;
+}
+
+// rasterize all glyphs into an alpha texture once - glyph rows are stored bottom up so texture coordinates grow in the same direction as screen coordinates
+static void CreateGlyphAtlas(void)
+{
+    static unsigned char pixels[GLYPH_ATLAS_HEIGHT][GLYPH_ATLAS_WIDTH];
+    memset(pixels, 0, sizeof(pixels));
+
+    for (int g = 0; g < (int) (sizeof(glyphRows) / sizeof(glyphRows[0])); g++)
+    {
+        for (int row = 0; row < GLYPH_HEIGHT; row++)
+        {
+            for (int column = 0; column < GLYPH_WIDTH; column++)
+            {
+                if ((glyphRows[g][row] & (0x10 >> column)) != 0)
+                    pixels[GLYPH_HEIGHT - 1 - row][g * GLYPH_CELL_WIDTH + column] = 0xff;
+            }
+        }
+    }
+
+    XPLMGenerateTextureNumbers(&glyphAtlasTexture, 1);
+    XPLMBindTexture2d(glyphAtlasTexture, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, GLYPH_ATLAS_WIDTH, GLYPH_ATLAS_HEIGHT, 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+// append text to a bounded buffer that already holds length characters - the text is cut off if it does not fit, returns the new length
+static int AppendText(char *buffer, int length, int size, const char *text)
+{
+    while (*text != '\0' && length < size - 1)
+        buffer[length++] = *text++;
+    buffer[length] = '\0';
+
+    return length;
+}
+
+// round the magnitude of a value below FORMAT_LIMIT to units of the last of 0 to 2 decimals the way printf's %.<decimals>f does - a float times 100 is exact in a double, so ties are found exactly and rounded to even
+static unsigned long long RoundToUnits(float value, int decimals)
+{
+    static const unsigned long long decimalScales[] = {1, 10, 100};
+
+    double scaled = fabs((double) value * (double) decimalScales[decimals]);
+    unsigned long long units = (unsigned long long) scaled;
+    double fraction = scaled - (double) units;
+    if (fraction > 0.5 || (fraction == 0.5 && (units & 1) != 0))
+        units++;
+
+    return units;
+}
+
+// append a value with 0 to 2 decimals to a bounded buffer - gives the same text as printf's %.<decimals>f, returns the new length
+static int AppendFixed(char *buffer, int length, int size, float value, int decimals)
+{
+    if (!(fabsf(value) < FORMAT_LIMIT))
+        return AppendText(buffer, length, size, "---");
+
+    unsigned long long units = RoundToUnits(value, decimals);
+
+    // digits are produced from the last one backwards
+    char digits[24];
+    int count = 0;
+    for (int i = 0; i < decimals; i++)
+    {
+        digits[count++] = (char) ('0' + units % 10);
+        units /= 10;
+    }
+    if (decimals > 0)
+        digits[count++] = '.';
+    do
+    {
+        digits[count++] = (char) ('0' + units % 10);
+        units /= 10;
+    }
+    while (units != 0);
+    if (signbit(value))
+        digits[count++] = '-';
+
+    while (count > 0 && length < size - 1)
+        buffer[length++] = digits[--count];
+    buffer[length] = '\0';
+
+    return length;
+}
+
+// format a hint showing a drift that is already wrapped into its range
+static void FormatDriftHint(float degrees)
+{
+    int length = AppendFixed(hintText, 0, HINT_TEXT_LENGTH, degrees, DRIFT_DECIMALS);
+    AppendText(hintText, length, HINT_TEXT_LENGTH, " deg");
+}
+
+// format a hint showing a barometer setting
+static void FormatBarometerHint(float barometerSettingInHg)
+{
+    int length = AppendFixed(hintText, 0, HINT_TEXT_LENGTH, barometerSettingInHg, BAROMETER_DECIMALS);
+    length = AppendText(hintText, length, HINT_TEXT_LENGTH, " inHg / ");
+    length = AppendFixed(hintText, length, HINT_TEXT_LENGTH, barometerSettingInHg * INHG_TO_MB, 0);
+    AppendText(hintText, length, HINT_TEXT_LENGTH, " mb");
+}
+
+// format a hint showing a heading that is already wrapped into its range
+static void FormatHeadingHint(float degrees)
+{
+    int length = AppendFixed(hintText, 0, HINT_TEXT_LENGTH, degrees, HEADING_DECIMALS);
+    AppendText(hintText, length, HINT_TEXT_LENGTH, " deg");
+}
+
+// bring hintText up to date with the current hint - does nothing while the text is still valid
+static void FormatHint(void)
+{
+    if (hintFormatted != 0)
+        return;
+
+    USDT_PROBE2(hint_format, hintKind, hintValue * 1000.0f);
+
+    switch (hintKind)
+    {
+    case WATCH_KIND_DRIFT:
+        FormatDriftHint(hintValue);
+        break;
+    case WATCH_KIND_HEADING:
+        FormatHeadingHint(hintValue);
+        break;
+    case WATCH_KIND_BAROMETER:
+        FormatBarometerHint(hintValue);
+        break;
+    }
+
+    hintFormatted = 1;
+    hintLayoutDirty = 1;
+}
+
+// make the given value the current hint - it is formatted when it is drawn first, so hints that are replaced or never become visible cost no formatting
+static void ShowHint(int kind, float value)
+{
+    if (kind != hintKind || value != hintValue)
+    {
+        hintKind = kind;
+        hintValue = value;
+        hintFormatted = 0;
+    }
+    lastHintTime = frameTime;
+
+    if (sessionFile != NULL)
+    {
+        FormatHint();
+        RecordHint();
+    }
+    ScheduleTask(TASK_UPDATE_HINT, -1.0f);
+}
+
+// scalar change-detection kernel - the reference all vectorized kernels must match bit for bit
+static void DiffScalar(const int *keys, const int *lastKeys, int count, unsigned int *changedMask)
+{
+    memset(changedMask, 0, ((count + 31) / 32) * sizeof(unsigned int));
+
+    for (int i = 0; i < count; i++)
+    {
+        if (keys[i] != lastKeys[i])
+            changedMask[i / 32] |= 1u << (i % 32);
+    }
+}
+
+#ifdef WATCH_SIMD
+// SSE2 change-detection kernel - handles full 32-entry words, the remainder is passed on to the scalar kernel
+TARGET_SSE2 static void DiffSse2(const int *keys, const int *lastKeys, int count, unsigned int *changedMask)
+{
+    int fullWords = count / 32;
+
+    for (int w = 0; w < fullWords; w++)
+    {
+        unsigned int equalMask = 0;
+        for (int j = 0; j < 32; j += 4)
+        {
+            int i = w * 32 + j;
+            __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) (keys + i)), _mm_loadu_si128((const __m128i*) (lastKeys + i)));
+            equalMask |= (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(equal)) << j;
+        }
+        changedMask[w] = ~equalMask;
+    }
+
+    if (count % 32 != 0)
+        DiffScalar(keys + fullWords * 32, lastKeys + fullWords * 32, count % 32, changedMask + fullWords);
+}
+
+// AVX2 change-detection kernel
+TARGET_AVX2 static void DiffAvx2(const int *keys, const int *lastKeys, int count, unsigned int *changedMask)
+{
+    int fullWords = count / 32;
+
+    for (int w = 0; w < fullWords; w++)
+    {
+        unsigned int equalMask = 0;
+        for (int j = 0; j < 32; j += 8)
+        {
+            int i = w * 32 + j;
+            __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (keys + i)), _mm256_loadu_si256((const __m256i*) (lastKeys + i)));
+            equalMask |= (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(equal)) << j;
+        }
+        changedMask[w] = ~equalMask;
+    }
+
+    if (count % 32 != 0)
+        DiffScalar(keys + fullWords * 32, lastKeys + fullWords * 32, count % 32, changedMask + fullWords);
+}
+
+// AVX-512 change-detection kernel
+TARGET_AVX512 static void DiffAvx512(const int *keys, const int *lastKeys, int count, unsigned int *changedMask)
+{
+    int fullWords = count / 32;
+
+    for (int w = 0; w < fullWords; w++)
+    {
+        int i = w * 32;
+        unsigned int maskLow = _mm512_cmpneq_epi32_mask(_mm512_loadu_si512(keys + i), _mm512_loadu_si512(lastKeys + i));
+        unsigned int maskHigh = _mm512_cmpneq_epi32_mask(_mm512_loadu_si512(keys + i + 16), _mm512_loadu_si512(lastKeys + i + 16));
+        changedMask[w] = maskLow | (maskHigh << 16);
+    }
+
+    if (count % 32 != 0)
+        DiffScalar(keys + fullWords * 32, lastKeys + fullWords * 32, count % 32, changedMask + fullWords);
+}
+#endif
+
+// scalar wrap kernel - never inlined into the vectorized kernels, whose instruction sets would let the compiler fuse the product into the subtraction for their remainders
+NO_INLINE static void WrapScalar(float *values, const float *mins, const float *ranges, int count)
+{
+    for (int i = 0; i < count; i++)
+        values[i] = WrapValue(values[i], mins[i], ranges[i]);
+}
+
+#ifdef WATCH_SIMD
+// SSE2 wrap kernel - SSE2 has no floor instruction, so it truncates and corrects the quotients that were rounded up, quotients of 2^23 and more are whole numbers already and are used as they are since the truncation overflows from 2^31 on
+TARGET_SSE2 static void WrapSse2(float *values, const float *mins, const float *ranges, int count)
+{
+    const __m128 one = _mm_set1_ps(1.0f), whole = _mm_set1_ps(8388608.0f), absolute = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    int fullCount = count - count % 4;
+
+    for (int i = 0; i < fullCount; i += 4)
+    {
+        __m128 value = _mm_loadu_ps(values + i), min = _mm_loadu_ps(mins + i), range = _mm_loadu_ps(ranges + i);
+        __m128 quotient = _mm_div_ps(_mm_sub_ps(value, min), range);
+        __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(quotient));
+        __m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, quotient), one));
+        __m128 large = _mm_cmpnlt_ps(_mm_and_ps(quotient, absolute), whole);
+        floored = _mm_or_ps(_mm_and_ps(large, quotient), _mm_andnot_ps(large, floored));
+        __m128 wrapped = _mm_max_ps(_mm_sub_ps(value, _mm_mul_ps(range, floored)), min);
+        __m128 inside = _mm_cmplt_ps(wrapped, _mm_add_ps(min, range));
+        wrapped = _mm_or_ps(_mm_and_ps(inside, wrapped), _mm_andnot_ps(inside, min));
+        __m128 enabled = _mm_cmpgt_ps(range, _mm_setzero_ps());
+        _mm_storeu_ps(values + i, _mm_or_ps(_mm_and_ps(enabled, wrapped), _mm_andnot_ps(enabled, value)));
+    }
+
+    WrapScalar(values + fullCount, mins + fullCount, ranges + fullCount, count - fullCount);
+}
+
+// AVX2 wrap kernel
+TARGET_AVX2 static void WrapAvx2(float *values, const float *mins, const float *ranges, int count)
+{
+    int fullCount = count - count % 8;
+
+    for (int i = 0; i < fullCount; i += 8)
+    {
+        __m256 value = _mm256_loadu_ps(values + i), min = _mm256_loadu_ps(mins + i), range = _mm256_loadu_ps(ranges + i);
+        __m256 floored = _mm256_floor_ps(_mm256_div_ps(_mm256_sub_ps(value, min), range));
+        __m256 wrapped = _mm256_max_ps(_mm256_sub_ps(value, _mm256_mul_ps(range, floored)), min);
+        wrapped = _mm256_blendv_ps(min, wrapped, _mm256_cmp_ps(wrapped, _mm256_add_ps(min, range), _CMP_LT_OQ));
+        _mm256_storeu_ps(values + i, _mm256_blendv_ps(value, wrapped, _mm256_cmp_ps(range, _mm256_setzero_ps(), _CMP_GT_OQ)));
+    }
+
+    WrapScalar(values + fullCount, mins + fullCount, ranges + fullCount, count - fullCount);
+}
+
+// AVX-512 wrap kernel
+TARGET_AVX512 static void WrapAvx512(float *values, const float *mins, const float *ranges, int count)
+{
+    int fullCount = count - count % 16;
+
+    for (int i = 0; i < fullCount; i += 16)
+    {
+        __m512 value = _mm512_loadu_ps(values + i), min = _mm512_loadu_ps(mins + i), range = _mm512_loadu_ps(ranges + i);
+        // the zero-masking forms avoid the undefined source operand GCC warns about, the explicit rounding form of the product keeps the compiler from fusing the product into the subtraction which the scalar reference does not do
+        __m512 floored = _mm512_maskz_roundscale_ps(0xffff, _mm512_div_ps(_mm512_sub_ps(value, min), range), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        __m512 wrapped = _mm512_maskz_max_ps(0xffff, _mm512_sub_ps(value, _mm512_maskz_mul_round_ps(0xffff, range, floored, _MM_FROUND_CUR_DIRECTION)), min);
+        wrapped = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(wrapped, _mm512_add_ps(min, range), _CMP_LT_OQ), min, wrapped);
+        _mm512_storeu_ps(values + i, _mm512_mask_blend_ps(_mm512_cmp_ps_mask(range, _mm512_setzero_ps(), _CMP_GT_OQ), value, wrapped));
+    }
+
+    WrapScalar(values + fullCount, mins + fullCount, ranges + fullCount, count - fullCount);
+}
+#endif
+
+// pick the widest change-detection and wrap kernels the CPU and operating system support
+static void SelectKernels(void)
+{
+    diffKernel = DiffScalar;
+    wrapKernel = WrapScalar;
+    const char *name = "scalar";
+
+#if defined(WATCH_SIMD) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        diffKernel = DiffAvx512;
+        wrapKernel = WrapAvx512;
+        name = "AVX-512";
+    }
+    else if (__builtin_cpu_supports("avx2"))
+    {
+        diffKernel = DiffAvx2;
+        wrapKernel = WrapAvx2;
+        name = "AVX2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        diffKernel = DiffSse2;
+        wrapKernel = WrapSse2;
+        name = "SSE2";
+    }
+#elif defined(WATCH_SIMD)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    int sse2 = (info[3] & (1 << 26)) != 0;
+    int osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x06) == 0x06;
+    int osAvx512 = osAvx && (_xgetbv(0) & 0xe6) == 0xe6;
+    int avx2 = 0, avx512 = 0;
+    if (maxLeaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = osAvx && (info[1] & (1 << 5)) != 0;
+        avx512 = osAvx512 && (info[1] & (1 << 16)) != 0;
+    }
+
+    if (avx512)
+    {
+        diffKernel = DiffAvx512;
+        wrapKernel = WrapAvx512;
+        name = "AVX-512";
+    }
+    else if (avx2)
+    {
+        diffKernel = DiffAvx2;
+        wrapKernel = WrapAvx2;
+        name = "AVX2";
+    }
+    else if (sse2)
+    {
+        diffKernel = DiffSse2;
+        wrapKernel = WrapSse2;
+        name = "SSE2";
+    }
+#endif
+
+    char message[64];
+    sprintf(message, NAME ": using %s change detection\n", name);
+    XPLMDebugString(message);
+}
+
+// resize a watch table array to the given capacity - returns 0 and keeps the old array if memory is exhausted
+static int GrowWatchArray(void **array, int capacity, size_t elementSize)
+{
+    void *grown = realloc(*array, capacity * elementSize);
+    allocations++;
+    if (grown == NULL)
+        return 0;
+
+    *array = grown;
+    return 1;
+}
+
+// return the type a dataref is read as - an element given as name[index] is read from a float or an int array, a plain name as float, double or int in that order of preference
+static XPLMDataTypeID SelectWatchType(XPLMDataTypeID types, int isElement)
+{
+    if (isElement != 0)
+    {
+        if ((types & xplmType_FloatArray) != 0)
+            return xplmType_FloatArray;
+        else if ((types & xplmType_IntArray) != 0)
+            return xplmType_IntArray;
+    }
+    else
+    {
+        if ((types & xplmType_Float) != 0)
+            return xplmType_Float;
+        else if ((types & xplmType_Double) != 0)
+            return xplmType_Double;
+        else if ((types & xplmType_Int) != 0)
+            return xplmType_Int;
+    }
+
+    return xplmType_Unknown;
+}
+
+// split a dataref given as name or as name[index] for an array element into name and index - returns 0 if the index is not a plain decimal number followed by the closing bracket at the end of the name
+static int ParseWatchName(const char *dataRefName, char *name, size_t size, int *element, int *isElement)
+{
+    strncpy(name, dataRefName, size - 1);
+    name[size - 1] = '\0';
+
+    *element = 0;
+    *isElement = 0;
+    char *bracket = strchr(name, '[');
+    if (bracket == NULL)
+        return 1;
+
+    char *end = NULL;
+    long index = strtol(bracket + 1, &end, 10);
+    if (bracket[1] < '0' || bracket[1] > '9' || end[0] != ']' || end[1] != '\0' || index > INT_MAX)
+        return 0;
+
+    *bracket = '\0';
+    *element = (int) index;
+    *isElement = 1;
+
+    return 1;
+}
+
+// find a dataref given as name or as name[index] for an array element
+static XPLMDataRef FindWatchDataRef(const char *dataRefName, int *element, int *isElement)
+{
+    char name[512];
+    if (ParseWatchName(dataRefName, name, sizeof(name), element, isElement) == 0)
+    {
+        XPLMDebugString(NAME ": ignoring dataref with invalid array index in " CONFIG_FILE_NAME "\n");
+        return NULL;
+    }
+
+    return XPLMFindDataRef(name);
+}
+
+// return 1 if a dataref given as name or as name[index] is well-formed but does not exist in the running sim - aircraft plugins may create it when their plane is loaded
+static int IsMissingDataRef(const char *dataRefName)
+{
+    char name[512];
+    int element = 0, isElement = 0;
+
+    return ParseWatchName(dataRefName, name, sizeof(name), &element, &isElement) != 0 && XPLMFindDataRef(name) == NULL;
+}
+
+// return the number of decimals a hint of the given kind is formatted with
+static int GetKindDecimals(int kind)
+{
+    return kind == WATCH_KIND_DRIFT ? DRIFT_DECIMALS : (kind == WATCH_KIND_HEADING ? HEADING_DECIMALS : BAROMETER_DECIMALS);
+}
+
+// return the number of units of the last formatted decimal a quantum spans - quanta finer than the formatted precision span one unit
+static int GetQuantumSteps(int kind, float quantum)
+{
+    static const float decimalScales[] = {1.0f, 10.0f, 100.0f};
+
+    double steps = rint((double) quantum * decimalScales[GetKindDecimals(kind)]);
+    return steps < 1.0 ? 1 : (steps < QUANTIZE_LIMIT ? (int) steps : QUANTIZE_LIMIT);
+}
+
+// add a dataref to the watch table - array elements are given as name[index], datarefs that do not exist in the running sim or have no numeric type are skipped, returns the index of the new entry or -1
+static int AddWatch(const char *dataRefName, int kind, float quantum)
+{
+    int element = 0, isElement = 0;
+    XPLMDataRef dataRef = FindWatchDataRef(dataRefName, &element, &isElement);
+    if (dataRef == NULL)
+        return -1;
+
+    XPLMDataTypeID type = SelectWatchType(XPLMGetDataRefTypes(dataRef), isElement);
+    if (type == xplmType_Unknown)
+        return -1;
+
+    int nameLength = (int) strlen(dataRefName) + 1;
+    if (watchNamePoolLength + nameLength > watchNamePoolCapacity)
+    {
+        int capacity = watchNamePoolCapacity == 0 ? WATCH_CAPACITY_STEP * 64 : watchNamePoolCapacity * 2;
+        while (capacity < watchNamePoolLength + nameLength)
+            capacity *= 2;
+
+        if (GrowWatchArray((void**) &watchNamePool, capacity, sizeof(char)) == 0)
+            return -1;
+
+        watchNamePoolCapacity = capacity;
+    }
+
+    if (watchCount == watchCapacity)
+    {
+        int capacity = watchCapacity == 0 ? WATCH_CAPACITY_STEP : watchCapacity * 2;
+
+        for (size_t i = 0; i < sizeof(watchArrays) / sizeof(watchArrays[0]); i++)
+        {
+            if (GrowWatchArray(watchArrays[i].array, capacity, watchArrays[i].elementSize) == 0)
+                return -1;
+        }
+
+        if (GrowWatchArray((void**) &watchChangedMask, capacity / 32, sizeof(unsigned int)) == 0)
+            return -1;
+
+        watchCapacity = capacity;
+    }
+
+    watchDataRefs[watchCount] = dataRef;
+    watchValues[watchCount] = 0.0f;
+    watchLastValues[watchCount] = 0.0f;
+    watchQuanta[watchCount] = quantum;
+    watchQuantumSteps[watchCount] = GetQuantumSteps(kind, quantum);
+    watchLastKeys[watchCount] = 0;
+    watchWrapMins[watchCount] = kind == WATCH_KIND_DRIFT ? DRIFT_WRAP_MIN : HEADING_WRAP_MIN;
+    watchWrapRanges[watchCount] = kind == WATCH_KIND_DRIFT ? DRIFT_WRAP_RANGE : (kind == WATCH_KIND_HEADING ? HEADING_WRAP_RANGE : 0.0f);
+    watchKinds[watchCount] = kind;
+    watchTypes[watchCount] = type;
+    watchElements[watchCount] = element;
+    watchIntervals[watchCount] = POLL_MIN_TICKS;
+    watchNext[watchCount] = WHEEL_UNLINKED;
+    watchEpochs[watchCount] = inputEpoch;
+    watchAliasPrimary[watchCount] = -1;
+    watchAliasSecondary[watchCount] = -1;
+    watchAliasStates[watchCount] = ALIAS_INDEPENDENT;
+    watchAliasMatches[watchCount] = 0;
+    watchSmoothing[watchCount] = 1.0f;
+    watchHysteresis[watchCount] = 0.0f;
+    watchSmoothed[watchCount] = 0.0f;
+    watchHeld[watchCount] = 0.0f;
+    watchFiltered[watchCount] = 0;
+    watchDebounce[watchCount] = 0;
+    watchPendingKeys[watchCount] = 0;
+    watchPendingPolls[watchCount] = 0;
+    watchDropped[watchCount] = WATCH_POLLED;
+    watchNameOffsets[watchCount] = watchNamePoolLength;
+    watchRecordedValues[watchCount] = 0.0f;
+    memcpy(watchNamePool + watchNamePoolLength, dataRefName, nameLength);
+    watchNamePoolLength += nameLength;
+    watchCount++;
+    watchPrimed = 0;
+
+    return watchCount - 1;
+}
+
+// return the number of quanta of the given steps a value is away from 0 after rounding it like the formatter - negative values count from -1 down since the formatter writes their sign even if they round to 0, values the formatter writes as dashes get INT_MIN
+static int QuantizeValue(float value, int decimals, int steps)
+{
+    if (!(fabsf(value) < FORMAT_LIMIT))
+        return INT_MIN;
+
+    unsigned long long quanta = RoundToUnits(value, decimals) / steps;
+    int key = quanta < QUANTIZE_LIMIT ? (int) quanta : QUANTIZE_LIMIT;
+
+    return signbit(value) ? -key - 1 : key;
+}
+
+// return the integer key of a wrapped value of the given kind - at a quantum of one formatted unit two values get the same key exactly if their hints read the same, coarser quanta group the units
+static int QuantizeKey(float value, int kind, int steps)
+{
+    int key = QuantizeValue(value, GetKindDecimals(kind), steps);
+
+    // at one unit per quantum the hint shows every millibar too - both parts only grow with the value, so their sum changes whenever one of them does
+    if (kind == WATCH_KIND_BAROMETER && steps == 1 && key != INT_MIN)
+    {
+        float millibars = value * INHG_TO_MB;
+        int millibarKey = QuantizeValue(millibars, 0, 1);
+        key += millibarKey != INT_MIN ? millibarKey : (signbit(millibars) ? -QUANTIZE_LIMIT - 1 : QUANTIZE_LIMIT);
+    }
+
+    return key;
+}
+
+// return the integer key of a wrapped value at the display precision of its entry
+static int QuantizeWatch(int index, float value)
+{
+    return QuantizeKey(value, watchKinds[index], watchQuantumSteps[index]);
+}
+
+// take a value over as the baseline the next reads of the entry are compared to - the noise filters start over from it
+static void SetWatchBaseline(int index, float value)
+{
+    watchLastValues[index] = value;
+    watchLastKeys[index] = QuantizeWatch(index, value);
+    watchSmoothed[index] = value;
+    watchHeld[index] = value;
+    watchPendingKeys[index] = watchLastKeys[index];
+    watchPendingPolls[index] = 0;
+}
+
+// return 1 while a changed key of a debounced entry is still pending - the key has to stay the same for the debounce number of further polls, a key that moves on starts the count over so a knob that is still being turned shows its hint only once it has settled
+static int DebounceChange(int index, int key)
+{
+    if (key != watchPendingKeys[index])
+    {
+        watchPendingKeys[index] = key;
+        watchPendingPolls[index] = 0;
+    }
+
+    return ++watchPendingPolls[index] <= watchDebounce[index];
+}
+
+// return the difference of two values of an entry - values with a wrap range take the shorter way around it
+static float GetWatchDelta(int index, float value, float reference)
+{
+    float range = watchWrapRanges[index];
+    return WrapValue(value - reference, -0.5f * range, range);
+}
+
+// read the current value of a watched dataref - every read goes through here, so a session records exactly the values the plugin saw
+static float ReadWatch(int index)
+{
+    float value = 0.0f;
+
+    switch (watchTypes[index])
+    {
+    case xplmType_Float:
+        value = XPLMGetDataf(watchDataRefs[index]);
+        break;
+    case xplmType_Double:
+        value = (float) XPLMGetDatad(watchDataRefs[index]);
+        break;
+    case xplmType_Int:
+        value = (float) XPLMGetDatai(watchDataRefs[index]);
+        break;
+    case xplmType_FloatArray:
+        XPLMGetDatavf(watchDataRefs[index], &value, watchElements[index], 1);
+        break;
+    case xplmType_IntArray:
+    {
+        int element = 0;
+        XPLMGetDatavi(watchDataRefs[index], &element, watchElements[index], 1);
+        value = (float) element;
+        break;
+    }
+    default:
+        break;
+    }
+
+    if (sessionFile != NULL)
+        RecordValue(index, value);
+
+    return value;
+}
+
+// read the current value of a watched dataref wrapped into its range - the scan wraps whole chunks at once instead
+static float ReadWrappedWatch(int index)
+{
+    return WrapValue(ReadWatch(index), watchWrapMins[index], watchWrapRanges[index]);
+}
+
+// return 1 if the given entry is a copilot entry that is polled along with its pilot entry
+static int FollowsAliasPrimary(int index)
+{
+    return watchAliasPrimary[index] >= 0 && watchAliasStates[index] != ALIAS_INDEPENDENT;
+}
+
+// insert a watch table entry into the timing wheel slot that lies the given number of ticks ahead - an entry that is in a slot already stays there
+static void InsertWatch(int index, int ticks)
+{
+    if (watchNext[index] != WHEEL_UNLINKED)
+        return;
+
+    int slot = (wheelTick + ticks) & (WHEEL_SLOT_COUNT - 1);
+    if (wheelSlots[slot] < 0)
+        wheelTails[slot] = index;
+    watchNext[index] = wheelSlots[slot];
+    wheelSlots[slot] = index;
+}
+
+// move the entries of all slots into the slot of the next tick - whole lists are linked, so this costs the same for any table size
+static void CollapseWheel(void)
+{
+    int next = (wheelTick + 1) & (WHEEL_SLOT_COUNT - 1);
+
+    for (int i = 0; i < WHEEL_SLOT_COUNT; i++)
+    {
+        if (i == next || wheelSlots[i] < 0)
+            continue;
+
+        watchNext[wheelTails[i]] = wheelSlots[next];
+        if (wheelSlots[next] < 0)
+            wheelTails[next] = wheelTails[i];
+        wheelSlots[next] = wheelSlots[i];
+        wheelSlots[i] = -1;
+    }
+}
+
+// make every entry due at the next tick with the minimum poll interval - fills the wheel after the watch table was built and after a plane load changed the alias states, copilot entries that are polled along with their pilot entry stay out
+static void ResetWheel(void)
+{
+    for (int i = 0; i < WHEEL_SLOT_COUNT; i++)
+        wheelSlots[i] = -1;
+
+    for (int i = watchCount - 1; i >= 0; i--)
+    {
+        watchNext[i] = WHEEL_UNLINKED;
+
+        // a restored entry that follows its pilot entry now is kept up to date by it
+        if (FollowsAliasPrimary(i) != 0 && watchDropped[i] == WATCH_RESTORED)
+            watchDropped[i] = WATCH_POLLED;
+        if (watchDropped[i] == WATCH_DROPPED || FollowsAliasPrimary(i) != 0)
+            continue;
+
+        watchIntervals[i] = POLL_MIN_TICKS;
+        watchEpochs[i] = inputEpoch;
+        InsertWatch(i, POLL_MIN_TICKS);
+    }
+
+    // entries of an unfinished scan are back in the wheel now
+    scanCount = scanPosition;
+}
+
+// write an alias message about the entry with the given index and its pilot entry to the log
+static void LogAlias(const char *format, int index)
+{
+    char message[128];
+    sprintf(message, format, index, watchAliasPrimary[index]);
+    XPLMDebugString(message);
+}
+
+// split a copilot entry off its pilot entry - it is polled on its own from the next tick on and reports the change that told the two apart
+static void SplitAlias(int index)
+{
+    if (watchAliasStates[index] == ALIAS_CONFIRMED)
+        LogAlias(NAME ": watch %d split from watch %d\n", index);
+
+    watchAliasStates[index] = ALIAS_INDEPENDENT;
+    watchIntervals[index] = POLL_MIN_TICKS;
+    watchEpochs[index] = inputEpoch;
+    InsertWatch(index, POLL_MIN_TICKS);
+}
+
+// advance the alias state of the copilot entry of a freshly read pilot entry given its wrapped value - a confirmed alias takes the pilot value over without a read except on the first poll after input, an observed one is read and compared every time
+static void FollowAlias(int primary, float value)
+{
+    int secondary = watchAliasSecondary[primary];
+    if (watchAliasStates[secondary] == ALIAS_INDEPENDENT)
+        return;
+
+    if (watchAliasStates[secondary] == ALIAS_CONFIRMED && watchEpochs[primary] == inputEpoch)
+    {
+        watchLastValues[secondary] = value;
+        watchLastKeys[secondary] = QuantizeWatch(secondary, value);
+        return;
+    }
+
+    float secondaryValue = ReadWrappedWatch(secondary);
+    if (secondaryValue != value)
+    {
+        SplitAlias(secondary);
+        return;
+    }
+
+    if (watchAliasStates[secondary] == ALIAS_OBSERVING && secondaryValue != watchLastValues[secondary] && ++watchAliasMatches[secondary] >= ALIAS_CONFIRM_CHANGES)
+    {
+        watchAliasStates[secondary] = ALIAS_CONFIRMED;
+        LogAlias(NAME ": watch %d is an alias of watch %d\n", secondary);
+    }
+
+    watchLastValues[secondary] = value;
+    watchLastKeys[secondary] = QuantizeWatch(secondary, value);
+}
+
+// advance the timing wheel by one tick and pack the indices of all entries in the new slot into watchDueIndices - returns their number
+static int CollectDueWatches(void)
+{
+    wheelTick++;
+    int slot = wheelTick & (WHEEL_SLOT_COUNT - 1);
+
+    int dueCount = 0;
+    for (int index = wheelSlots[slot]; index >= 0;)
+    {
+        int next = watchNext[index];
+        watchNext[index] = WHEEL_UNLINKED;
+        watchDueIndices[dueCount++] = index;
+        index = next;
+    }
+    wheelSlots[slot] = -1;
+
+    return dueCount;
+}
+
+// run a freshly read and wrapped value of a filtered entry through the smoothing and hysteresis stages of its noise filter and return the filtered value - smoothing moves along the shorter way around a wrapped range and may step over its bound, so the result is wrapped again
+static float FilterValue(int index, float value)
+{
+    if (watchSmoothing[index] < 1.0f)
+    {
+        value = watchSmoothed[index] + watchSmoothing[index] * GetWatchDelta(index, value, watchSmoothed[index]);
+        value = WrapValue(value, watchWrapMins[index], watchWrapRanges[index]);
+        watchSmoothed[index] = value;
+    }
+
+    if (fabsf(GetWatchDelta(index, value, watchHeld[index])) <= watchHysteresis[index] * watchQuanta[index])
+        value = watchHeld[index];
+    else
+        watchHeld[index] = value;
+
+    return value;
+}
+
+// run the smoothing and hysteresis stages of the noise filters over the freshly read values of a chunk - the values are replaced by their filtered ones
+static void FilterDueWatches(int start, int count)
+{
+    for (int d = start; d < start + count; d++)
+    {
+        int index = watchDueIndices[d];
+        if (watchFiltered[index] != 0)
+            watchValues[d] = FilterValue(index, watchValues[d]);
+    }
+}
+
+// return the watch table entry of the given dataref or -1 if it is not watched
+static int FindWatch(const char *dataRefName)
+{
+    int element = 0, isElement = 0;
+    XPLMDataRef dataRef = FindWatchDataRef(dataRefName, &element, &isElement);
+    if (dataRef == NULL)
+        return -1;
+
+    for (int i = 0; i < watchCount; i++)
+    {
+        if (watchDataRefs[i] == dataRef && watchElements[i] == element)
+            return i;
+    }
+
+    return -1;
+}
+
+// add a built-in watch unless the config file already watches its dataref
+static void AddBuiltInWatch(const char *dataRefName, int kind, float quantum)
+{
+    if (FindWatch(dataRefName) < 0)
+        AddWatch(dataRefName, kind, quantum);
+}
+
+// declare a copilot dataref as a possible alias of a pilot dataref - whether it really is one is found out while polling
+static void PairWatches(const char *primaryName, const char *secondaryName)
+{
+    int primary = FindWatch(primaryName), secondary = FindWatch(secondaryName);
+    if (primary < 0 || secondary < 0 || primary == secondary || watchAliasPrimary[primary] >= 0 || watchAliasSecondary[primary] >= 0 || watchAliasPrimary[secondary] >= 0 || watchAliasSecondary[secondary] >= 0)
+        return;
+
+    watchAliasPrimary[secondary] = primary;
+    watchAliasSecondary[primary] = secondary;
+    watchAliasStates[secondary] = ALIAS_OBSERVING;
+    watchAliasMatches[secondary] = 0;
+}
+
+// start observing all declared pairs again - a newly loaded plane may wire its pilot and copilot instruments differently, every entry is due at the next tick
+static void ResetAliases(void)
+{
+    for (int i = 0; i < watchCount; i++)
+    {
+        if (watchAliasPrimary[i] >= 0)
+        {
+            watchAliasStates[i] = ALIAS_OBSERVING;
+            watchAliasMatches[i] = 0;
+        }
+    }
+
+    // copilot entries that were split off leave the wheel again
+    ResetWheel();
+}
+
+// add a noise filter rule for a dataref - datarefs that do not exist in the running sim are skipped, returns 0 in that case
+static int AddFilterRule(const char *dataRefName, float smoothing, float hysteresis, int debounce)
+{
+    if (filterRuleCount == MAX_FILTER_RULES)
+        return 1;
+
+    int element = 0, isElement = 0;
+    XPLMDataRef dataRef = FindWatchDataRef(dataRefName, &element, &isElement);
+    if (dataRef == NULL)
+        return IsMissingDataRef(dataRefName) == 0;
+
+    FilterRule *rule = &filterRules[filterRuleCount++];
+    rule->dataRef = dataRef;
+    rule->element = element;
+    rule->smoothing = smoothing > 0.0f && smoothing < 1.0f ? smoothing : 1.0f;
+    rule->hysteresis = hysteresis > 0.0f ? hysteresis : 0.0f;
+    rule->debounce = debounce > 0 ? debounce : 0;
+
+    return 1;
+}
+
+// apply the noise filter rules to the watch table entries of their datarefs - rules of datarefs that are not watched have no effect, rules before the first new one only apply to entries from the first new one on as the others already have them, and entries before the first new one that a new rule changes are recorded as they are already described in the session file
+static void ApplyFilterRules(int firstRule, int firstWatch)
+{
+    for (int i = 0; i < filterRuleCount; i++)
+    {
+        FilterRule *rule = &filterRules[i];
+
+        for (int j = i < firstRule ? firstWatch : 0; j < watchCount; j++)
+        {
+            if (watchDataRefs[j] == rule->dataRef && watchElements[j] == rule->element)
+            {
+                watchSmoothing[j] = rule->smoothing;
+                watchHysteresis[j] = rule->hysteresis;
+                watchDebounce[j] = rule->debounce;
+                watchFiltered[j] = rule->smoothing < 1.0f || rule->hysteresis > 0.0f;
+
+                if (j < firstWatch && sessionFile != NULL)
+                    RecordFilter(j);
+            }
+        }
+    }
+}
+
+// bind a watched dataref to a command - commands or datarefs that do not exist in the running sim and bindings that already exist are skipped, returns 0 if the command or the dataref does not exist
+static int AddCommandBinding(const char *commandName, const char *dataRefName)
+{
+    if (commandBindingCount == MAX_COMMAND_BINDINGS)
+        return 1;
+
+    XPLMCommandRef command = XPLMFindCommand(commandName);
+    int element = 0, isElement = 0;
+    XPLMDataRef dataRef = FindWatchDataRef(dataRefName, &element, &isElement);
+    if (command == NULL)
+        return 0;
+    if (dataRef == NULL)
+        return IsMissingDataRef(dataRefName) == 0;
+
+    for (int i = 0; i < commandBindingCount; i++)
+    {
+        if (commandBindings[i].command == command && commandBindings[i].dataRef == dataRef && commandBindings[i].element == element)
+            return 1;
+    }
+
+    CommandBinding *binding = &commandBindings[commandBindingCount++];
+    strncpy(binding->commandName, commandName, sizeof(binding->commandName) - 1);
+    binding->commandName[sizeof(binding->commandName) - 1] = '\0';
+    binding->command = command;
+    binding->dataRef = dataRef;
+    binding->element = element;
+    binding->watchIndex = -1;
+
+    return 1;
+}
+
+// command handler that runs before X-Plane handles a bound command - when the command begins it takes the current value as baseline, then and while it is held down it schedules a one-shot read for after the command, the end of a command changes nothing
+static int HandleCommand(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void *inRefcon)
+{
+    if (inPhase != xplm_CommandBegin && inPhase != xplm_CommandContinue)
+        return 1;
+
+    int index = ((CommandBinding*) inRefcon)->watchIndex;
+
+    frameTime = XPLMGetElapsedTime();
+    lastInputTime = frameTime;
+
+    if (sessionFile != NULL)
+        RecordCommand(index, inPhase);
+
+    for (int i = 0; i < commandWatchCount; i++)
+    {
+        if (commandWatchIndices[i] == index)
+            return 1;
+    }
+
+    // the value before the command takes effect is the baseline, while the command repeats its filters keep their state
+    if (inPhase == xplm_CommandBegin)
+        SetWatchBaseline(index, ReadWrappedWatch(index));
+    commandWatchIndices[commandWatchCount++] = index;
+    ScheduleTask(TASK_READ_COMMAND_WATCHES, -1.0f);
 
-// define QPAC A320 plugin signature
-#define QPAC_A320_PLUGIN_SIGNATURE "QPAC.airbus.fbw"
+    return 1;
+}
 
-// define hint duration
-#define HINT_DURATION 4.0f
+// map the command bindings from the given one on to their watch table entries and register their command handlers - bindings of datarefs that are not watched are dropped, the bindings before the given one are registered already and keep their place
+static void RegisterCommandBindings(int first)
+{
+    int count = first;
 
-// global dataref variables
-static XPLMDataRef dgDriftVacDegDataRef = NULL, dgDriftEleDegDataRef = NULL, dgDriftVac2DegDataRef = NULL, dgDriftEle2DegDataRef = NULL, headingDialDegMagPilotDataRef = NULL, headingDialDegMagCopilotDataRef = NULL, barometerSettingInHgPilotDataRef = NULL, barometerSettingInHgCopilotDataRef = NULL, adf1CardHeadingDegMagPilotDataRef = NULL, adf2CardHeadingDegMagPilotDataRef = NULL, adf1CardHeadingDegMagCopilotDataRef = NULL, adf2CardHeadingDegMagCopilotDataRef = NULL, hsiObsDegMagPilotDataRef = NULL, hsiObsDegMagCopilotDataRef = NULL, nav1ObsDegMagPilotDataRef = NULL, nav2ObsDegMagPilotDataRef = NULL, nav1ObsDegMagCopilotDataRef = NULL, nav2ObsDegMagCopilotDataRef = NULL;
+    for (int i = first; i < commandBindingCount; i++)
+    {
+        CommandBinding *binding = &commandBindings[i];
 
-// global internal variables
-static char hintText[32] = "";
-static int bringFakeWindowToFront = 0, lastChangeDetected = 0, forceDisplay = 0;
-static float lastMouseUsageTime = 0.0f, lastHintTime = 0.0f, lastDgDriftVacDeg = FLT_MAX, lastDgDriftEleDeg = FLT_MAX, lastDgDriftVac2Deg = FLT_MAX, lastDgDriftEle2Deg = FLT_MAX, lastHeadingDialDegMagPilot = FLT_MAX, lastHeadingDialDegMagCopilot = FLT_MAX, lastBarometerSettingInHgPilot = FLT_MAX, lastBarometerSettingInHgCopilot = FLT_MAX, lastAdf1CardHeadingDegMagPilot = FLT_MAX, lastAdf2CardHeadingDegMagPilot = FLT_MAX, lastAdf1CardHeadingDegMagCopilot = FLT_MAX, lastAdf2CardHeadingDegMagCopilot = FLT_MAX, lastHsiObsDegMagPilot = FLT_MAX, lastHsiObsDegMagCopilot = FLT_MAX, lastNav1ObsDegMagPilot = FLT_MAX, lastNav2ObsDegMagPilot = FLT_MAX, lastNav1ObsDegMagCopilot = FLT_MAX, lastNav2ObsDegMagCopilot = FLT_MAX;
-static XPLMWindowID fakeWindow = NULL;
+        for (int j = 0; j < watchCount; j++)
+        {
+            if (watchDataRefs[j] == binding->dataRef && watchElements[j] == binding->element)
+            {
+                binding->watchIndex = j;
+                break;
+            }
+        }
+
+        if (binding->watchIndex >= 0)
+            commandBindings[count++] = *binding;
+    }
 
-// flightloop-callback that resizes and brings the fake window back to the front if needed
-static float UpdateFakeWindowCallback(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void *inRefcon)
+    commandBindingCount = count;
+    for (int i = first; i < commandBindingCount; i++)
+        XPLMRegisterCommandHandler(commandBindings[i].command, HandleCommand, 1, &commandBindings[i]);
+}
+
+// unregister all command handlers and forget the bindings
+static void UnregisterCommandBindings(void)
 {
-    if (fakeWindow != NULL)
+    for (int i = 0; i < commandBindingCount; i++)
+        XPLMUnregisterCommandHandler(commandBindings[i].command, HandleCommand, 1, &commandBindings[i]);
+
+    commandBindingCount = 0;
+    commandWatchCount = 0;
+}
+
+// parse the arguments of a config line of the form: command <command> <dataref>[[<index>]] [<dataref>[[<index>]] ...] - returns 0 if the command or one of the datarefs does not exist in the running sim yet
+static int ParseCommandBinding(char *arguments)
+{
+    char *command = strtok(arguments, " \t\r\n");
+    if (command == NULL)
+        return 1;
+
+    int resolved = 1;
+    for (char *dataRef = strtok(NULL, " \t\r\n"); dataRef != NULL; dataRef = strtok(NULL, " \t\r\n"))
+        resolved &= AddCommandBinding(command, dataRef);
+
+    return resolved;
+}
+
+// parse the arguments of a config line of the form: filter <dataref>[[<index>]] <smoothing> [<hysteresis> [<debounce>]] - returns 0 if the dataref does not exist in the running sim yet
+static int ParseFilterRule(char *arguments)
+{
+    char *name = strtok(arguments, " \t\r\n");
+    char *smoothing = strtok(NULL, " \t\r\n");
+    char *hysteresis = strtok(NULL, " \t\r\n");
+    char *debounce = hysteresis != NULL ? strtok(NULL, " \t\r\n") : NULL;
+    if (name == NULL || smoothing == NULL)
+        return 1;
+
+    return AddFilterRule(name, (float) atof(smoothing), hysteresis != NULL ? (float) atof(hysteresis) : 0.0f, debounce != NULL ? atoi(debounce) : 0);
+}
+
+// parse the arguments of a config line of the form: watch <dataref>[[<index>]] <kind> [<quantum> [<min> <max>]] - values are wrapped into [min, max) if a range is given, returns 0 if the dataref does not exist in the running sim yet
+static int ParseWatch(char *arguments)
+{
+    char *name = strtok(arguments, " \t\r\n");
+    char *kindName = strtok(NULL, " \t\r\n");
+    char *quantumText = strtok(NULL, " \t\r\n");
+    char *minText = quantumText != NULL ? strtok(NULL, " \t\r\n") : NULL;
+    char *maxText = minText != NULL ? strtok(NULL, " \t\r\n") : NULL;
+    if (name == NULL || kindName == NULL)
+        return 1;
+
+    int kind = ParseWatchKind(kindName);
+    if (kind < 0)
     {
-        int x = 0, y = 0;
-        XPLMGetScreenSize(&x, &y);
-        XPLMSetWindowGeometry(fakeWindow, 0, y, x, 0);
+        XPLMDebugString(NAME ": ignoring watch with unknown hint kind in " CONFIG_FILE_NAME "\n");
+        return 1;
+    }
+
+    if (IsMissingDataRef(name) != 0)
+        return 0;
+
+    float quantum = quantumText != NULL ? (float) atof(quantumText) : 0.0f;
+    if (quantum <= 0.0f)
+        quantum = kind == WATCH_KIND_DRIFT ? DRIFT_QUANTUM : (kind == WATCH_KIND_HEADING ? HEADING_QUANTUM : BAROMETER_QUANTUM);
+
+    int index = AddWatch(name, kind, quantum);
+    if (index >= 0 && maxText != NULL)
+    {
+        float min = (float) atof(minText), max = (float) atof(maxText);
+        watchWrapMins[index] = min;
+        watchWrapRanges[index] = max > min ? max - min : 0.0f;
+    }
+
+    return 1;
+}
+
+// parse a watch, command or filter line of the config file - returns 0 if it names a dataref or command that does not exist in the running sim yet
+static int ParseDataRefLine(const char *line)
+{
+    char keyword[32], arguments[512];
+    int offset = 0;
+    if (sscanf(line, "%31s%n", keyword, &offset) != 1)
+        return 1;
+
+    strncpy(arguments, line + offset, sizeof(arguments) - 1);
+    arguments[sizeof(arguments) - 1] = '\0';
+
+    if (strcmp(keyword, "watch") == 0)
+        return ParseWatch(arguments);
+    else if (strcmp(keyword, "command") == 0)
+        return ParseCommandBinding(arguments);
+    else
+        return ParseFilterRule(arguments);
+}
+
+// keep a config line that waits for its datarefs or commands
+static void AddPendingLine(const char *line)
+{
+    if (pendingLineCount == MAX_PENDING_LINES)
+    {
+        XPLMDebugString(NAME ": too many unresolved lines in " CONFIG_FILE_NAME ", ignoring the rest\n");
+        return;
+    }
+
+    snprintf(pendingLines[pendingLineCount++], sizeof(pendingLines[0]), "%s", line);
+}
+
+// parse the pending config lines again after a plane load - aircraft plugins create their datarefs and commands then, the new watch table entries get their filters and command handlers and are described in the session file along with the filters new rules gave older entries, ResetWheel has to run afterwards so they get polled
+static void ResolvePendingLines(void)
+{
+    int firstWatch = watchCount, firstBinding = commandBindingCount, firstRule = filterRuleCount, count = 0;
+
+    for (int i = 0; i < pendingLineCount; i++)
+    {
+        if (ParseDataRefLine(pendingLines[i]) != 0)
+            continue;
+
+        if (count != i)
+            memcpy(pendingLines[count], pendingLines[i], sizeof(pendingLines[0]));
+        count++;
+    }
+    pendingLineCount = count;
+
+    if (watchCount == firstWatch && commandBindingCount == firstBinding && filterRuleCount == firstRule)
+        return;
+
+    ApplyFilterRules(firstRule, firstWatch);
+    RegisterCommandBindings(firstBinding);
 
-        if (bringFakeWindowToFront == 0)
+    if (sessionFile != NULL)
+    {
+        RecordWatches(firstWatch);
+        RecordCommandBindings(firstBinding);
+    }
+}
+
+// read the optional config file from the plugin's folder
+static void LoadConfig(void)
+{
+    char path[1024];
+    GetPluginFilePath(path, sizeof(path), CONFIG_FILE_NAME);
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return;
+
+    char line[512];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char keyword[32];
+        int offset = 0;
+        if (sscanf(line, "%31s%n", keyword, &offset) != 1 || keyword[0] == '#')
+            continue;
+
+        if (strcmp(keyword, "suppress") == 0)
+            ParseSuppressionRule(line + offset);
+        else if (strcmp(keyword, "watch") == 0 || strcmp(keyword, "command") == 0 || strcmp(keyword, "filter") == 0)
         {
-            XPLMBringWindowToFront(fakeWindow);
-            bringFakeWindowToFront = 1;
+            if (ParseDataRefLine(line) == 0)
+                AddPendingLine(line);
         }
+        else if (strcmp(keyword, "scan_budget") == 0)
+            scanBudget = atof(line + offset) * 1.0e-6;
+        else if (strcmp(keyword, "frame_budget") == 0)
+            frameBudget = atof(line + offset) * 1.0e-6;
+        else if (strcmp(keyword, "record") == 0)
+            StartRecording();
+        else if (strcmp(keyword, "profile") == 0)
+            profiling = 1;
+        else if (strcmp(keyword, "trace") == 0)
+            StartTracing();
+        else
+            XPLMDebugString(NAME ": ignoring unknown keyword in " CONFIG_FILE_NAME "\n");
     }
 
-    return -1.0f;
+    fclose(file);
 }
 
-// check if a plugin with a given signature is enabled
-static int IsPluginEnabled(const char* pluginSignature)
+// release all memory held by the watch table
+static void ClearWatches(void)
 {
-    XPLMPluginID pluginId = XPLMFindPluginBySignature(pluginSignature);
+    for (size_t i = 0; i < sizeof(watchArrays) / sizeof(watchArrays[0]); i++)
+    {
+        free(*watchArrays[i].array);
+        *watchArrays[i].array = NULL;
+    }
 
-    return XPLMIsPluginEnabled(pluginId);
+    free(watchChangedMask);
+    watchChangedMask = NULL;
+    free(watchNamePool);
+    watchNamePool = NULL;
+    watchNamePoolLength = 0;
+    watchNamePoolCapacity = 0;
+    watchCount = 0;
+    watchCapacity = 0;
+    watchPrimed = 0;
+    droppedWatchCount = 0;
 }
 
-// if the given value is beyond the range a value that is inside the given range is returned - the behavior resembles integer underflows / overflows occured - values inside the given range are simply returned
-static float HandleOverflow(float value, float min, float max)
+// display the hint that belongs to the watch table entry with the given index unless an enabled plugin suppresses its kind
+static void DisplayWatchHint(int index, float value)
 {
-    float a = max - min;
-    float b = (float) fabs(value - max);
-    float r = b - a * (float) ((int) b / (int) a);
+    USDT_PROBE2(change_detected, index, value * 1000.0f);
 
-    if (value < min)
-        return max - r;
-    else if (value > max)
-        return min + r;
-    else
-        return value;
-}
-
-// display a hint showing a drift between -180 and 180 degrees
-static void DisplayDriftHint(float degrees)
-{
-    if (IsPluginEnabled(QPAC_A320_PLUGIN_SIGNATURE) == 0)
-    {
-        sprintf(hintText, "%.1f deg", HandleOverflow(degrees, -180.0f, 180.0f));
-        lastHintTime = XPLMGetElapsedTime();
-    }
-}
-
-// display a hint showing a barometer setting
-static void DisplayBarometerHint(float barometerSettingInHg)
-{
-    sprintf(hintText, "%.2f inHg / %.0f mb", barometerSettingInHg, barometerSettingInHg * 33.8638866667f);
-    lastHintTime = XPLMGetElapsedTime();
-}
-
-// display a hint showing a heading between 0 and 360 degrees
-static void DisplayHeadingHint(float degrees)
-{
-    if (IsPluginEnabled(QPAC_A320_PLUGIN_SIGNATURE) == 0)
-    {
-        sprintf(hintText, "%.0f deg", HandleOverflow(degrees, 0.0f, 360.0f));
-        lastHintTime = XPLMGetElapsedTime();
-    }
-}
-
-// flightloop-callback that handles which hint is displayed when
-static float FlightLoopCallback(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void *inRefcon)
-{
-    float dgDriftVacDeg = XPLMGetDataf(dgDriftVacDegDataRef);
-    float dgDriftEleDeg = XPLMGetDataf(dgDriftEleDegDataRef);
-    float dgDriftVac2Deg = XPLMGetDataf(dgDriftVac2DegDataRef);
-    float dgDriftEle2Deg = XPLMGetDataf(dgDriftEle2DegDataRef);
-    float headingDialDegMagPilot = XPLMGetDataf(headingDialDegMagPilotDataRef);
-    float headingDialDegMagCopilot = XPLMGetDataf(headingDialDegMagCopilotDataRef);
-    float barometerSettingInHgPilot = XPLMGetDataf(barometerSettingInHgPilotDataRef);
-    float barometerSettingInHgCopilot = XPLMGetDataf(barometerSettingInHgCopilotDataRef);
-    float adf1CardHeadingDegMagPilot = XPLMGetDataf(adf1CardHeadingDegMagPilotDataRef);
-    float adf2CardHeadingDegMagPilot= XPLMGetDataf(adf2CardHeadingDegMagPilotDataRef);
-    float adf1CardHeadingDegMagCopilot= XPLMGetDataf(adf1CardHeadingDegMagCopilotDataRef);
-    float adf2CardHeadingDegMagCopilot= XPLMGetDataf(adf2CardHeadingDegMagCopilotDataRef);
-    float hsiObsDegMagPilot = XPLMGetDataf(hsiObsDegMagPilotDataRef);
-    float hsiObsDegMagCopilot = XPLMGetDataf(hsiObsDegMagCopilotDataRef);
-    float nav1ObsDegMagPilot = XPLMGetDataf(nav1ObsDegMagPilotDataRef);
-    float nav2ObsDegMagPilot = XPLMGetDataf(nav2ObsDegMagPilotDataRef);
-    float nav1ObsDegMagCopilot = XPLMGetDataf(nav1ObsDegMagCopilotDataRef);
-    float nav2ObsDegMagCopilot = XPLMGetDataf(nav2ObsDegMagCopilotDataRef);
-
-    int changeDetected = 1;
-
-    if (lastDgDriftVacDeg != FLT_MAX && fabs(dgDriftVacDeg - lastDgDriftVacDeg) > 0.01f)
-        DisplayDriftHint(dgDriftVacDeg);
-    else if (lastDgDriftEleDeg != FLT_MAX && fabs(dgDriftEleDeg - lastDgDriftEleDeg) > 0.01f)
-        DisplayDriftHint(dgDriftEleDeg);
-    else if (lastDgDriftVac2Deg != FLT_MAX && fabs(dgDriftVac2Deg - lastDgDriftVac2Deg) > 0.01f)
-        DisplayDriftHint(dgDriftVac2Deg);
-    else if (lastDgDriftEle2Deg != FLT_MAX && fabs(dgDriftEle2Deg - lastDgDriftEle2Deg) > 0.01f)
-        DisplayDriftHint(dgDriftEle2Deg);
-    else if (lastHeadingDialDegMagPilot != FLT_MAX && headingDialDegMagPilot != lastHeadingDialDegMagPilot)
-        DisplayHeadingHint(headingDialDegMagPilot);
-    else if (lastHeadingDialDegMagCopilot != FLT_MAX && headingDialDegMagCopilot != lastHeadingDialDegMagCopilot)
-        DisplayHeadingHint(headingDialDegMagCopilot);
-    else if (lastBarometerSettingInHgPilot != FLT_MAX && barometerSettingInHgPilot != lastBarometerSettingInHgPilot)
-        DisplayBarometerHint(barometerSettingInHgPilot);
-    else if (lastBarometerSettingInHgCopilot != FLT_MAX && barometerSettingInHgCopilot != lastBarometerSettingInHgCopilot)
-        DisplayBarometerHint(barometerSettingInHgCopilot);
-    else if (lastBarometerSettingInHgCopilot != FLT_MAX && barometerSettingInHgCopilot != lastBarometerSettingInHgCopilot)
-        DisplayBarometerHint(barometerSettingInHgCopilot);
-    else if (lastAdf1CardHeadingDegMagPilot != FLT_MAX && adf1CardHeadingDegMagPilot != lastAdf1CardHeadingDegMagPilot)
-        DisplayHeadingHint(adf1CardHeadingDegMagPilot);
-    else if (lastAdf2CardHeadingDegMagPilot != FLT_MAX && adf2CardHeadingDegMagPilot != lastAdf2CardHeadingDegMagPilot)
-        DisplayHeadingHint(adf2CardHeadingDegMagPilot);
-    else if (lastAdf1CardHeadingDegMagCopilot != FLT_MAX && adf1CardHeadingDegMagCopilot != lastAdf1CardHeadingDegMagCopilot)
-        DisplayHeadingHint(adf1CardHeadingDegMagCopilot);
-    else if (lastAdf2CardHeadingDegMagCopilot != FLT_MAX && adf2CardHeadingDegMagCopilot != lastAdf2CardHeadingDegMagCopilot)
-        DisplayHeadingHint(adf2CardHeadingDegMagCopilot);
-    else if (lastHsiObsDegMagPilot != FLT_MAX && hsiObsDegMagPilot != lastHsiObsDegMagPilot)
-        DisplayHeadingHint(hsiObsDegMagPilot);
-    else if (lastHsiObsDegMagCopilot != FLT_MAX && hsiObsDegMagCopilot != lastHsiObsDegMagCopilot)
-        DisplayHeadingHint(hsiObsDegMagCopilot);
-    else if (lastNav1ObsDegMagPilot != FLT_MAX && nav1ObsDegMagPilot != lastNav1ObsDegMagPilot)
-        DisplayHeadingHint(nav1ObsDegMagPilot);
-    else if (lastNav2ObsDegMagPilot != FLT_MAX && nav2ObsDegMagPilot != lastNav2ObsDegMagPilot)
-        DisplayHeadingHint(nav2ObsDegMagPilot);
-    else if (lastNav1ObsDegMagCopilot != FLT_MAX && nav1ObsDegMagCopilot != lastNav1ObsDegMagCopilot)
-        DisplayHeadingHint(nav1ObsDegMagCopilot);
-    else if (lastNav2ObsDegMagCopilot != FLT_MAX && nav2ObsDegMagCopilot != lastNav2ObsDegMagCopilot)
-        DisplayHeadingHint(nav2ObsDegMagCopilot);
-    else
-        changeDetected = 0;
+    if ((suppressedKinds & WATCH_KIND_BIT(watchKinds[index])) != 0)
+        return;
+
+    ProbeStart probeStart;
+    BeginProbe(PROBE_DISPLAY_HINT, &probeStart);
+
+    ShowHint(watchKinds[index], value);
+
+    EndProbe(PROBE_DISPLAY_HINT, &probeStart);
+}
+
+// read a watched dataref while the governor drops expensive entries - an entry whose read takes too large a share of the frame budget is not polled again until the governor recovers
+static float ReadGovernedWatch(int index)
+{
+    unsigned long long ticks = ReadProbeTicks();
+    float value = ReadWatch(index);
+    ticks = ReadProbeTicks() - ticks;
+
+    if (ticks > expensiveReadTicks)
+    {
+        watchDropped[index] = WATCH_DROPPED;
+        droppedWatchCount++;
+
+        char message[96];
+        sprintf(message, NAME ": governor dropped watch %d, reading it took %.0f us\n", index, ticks * 1.0e6 / GetProbeTicksPerSecond());
+        XPLMDebugString(message);
+    }
+
+    return value;
+}
+
+// poll the entries the governor dropped again once it recovered - they are due at the next tick and the scan takes their first values over as baseline within its budget, copilot entries that follow their pilot entry are kept up to date by it and stay out of the wheel
+static void RestoreDroppedWatches(void)
+{
+    for (int i = 0; i < watchCount; i++)
+    {
+        if (watchDropped[i] != WATCH_DROPPED)
+            continue;
+
+        if (FollowsAliasPrimary(i) != 0)
+        {
+            watchDropped[i] = WATCH_POLLED;
+            continue;
+        }
+
+        watchDropped[i] = WATCH_RESTORED;
+        watchIntervals[i] = POLL_MIN_TICKS;
+        watchEpochs[i] = inputEpoch;
+        InsertWatch(i, POLL_MIN_TICKS);
+    }
+    droppedWatchCount = 0;
+
+    XPLMDebugString(NAME ": governor restored dropped watches\n");
+}
+
+// read and diff the next chunk of due entries, adapt their poll intervals and remember the changed entry with the lowest index
+static void ScanChunk(void)
+{
+    int start = scanPosition;
+    int count = scanCount - start < SCAN_CHUNK_SIZE ? scanCount - start : SCAN_CHUNK_SIZE;
+
+    for (int d = start; d < start + count; d++)
+    {
+        int index = watchDueIndices[d];
+        watchValues[d] = governorLevel >= GOVERNOR_DROP_EXPENSIVE ? ReadGovernedWatch(index) : ReadWatch(index);
+        watchDueLastKeys[d] = watchLastKeys[index];
+        watchDueWrapMins[d] = watchWrapMins[index];
+        watchDueWrapRanges[d] = watchWrapRanges[index];
+    }
+
+    wrapKernel(watchValues + start, watchDueWrapMins + start, watchDueWrapRanges + start, count);
+
+    // restored entries take their first value over as baseline, copilot entries are compared with the wrapped value of their pilot entry before the noise filters change it - the pilot entry reports the changes of both
+    for (int d = start; d < start + count; d++)
+    {
+        int index = watchDueIndices[d];
+        if (watchDropped[index] == WATCH_RESTORED)
+        {
+            watchDropped[index] = WATCH_POLLED;
+            SetWatchBaseline(index, watchValues[d]);
+            watchDueLastKeys[d] = watchLastKeys[index];
+        }
+
+        if (watchAliasSecondary[index] >= 0 && watchDropped[index] == WATCH_POLLED)
+            FollowAlias(index, watchValues[d]);
+    }
+
+    FilterDueWatches(start, count);
+
+    for (int d = start; d < start + count; d++)
+        watchDueKeys[d] = QuantizeWatch(watchDueIndices[d], watchValues[d]);
+
+    diffKernel(watchDueKeys + start, watchDueLastKeys + start, count, watchChangedMask);
+
+    for (int d = 0; d < count; d++)
+    {
+        int index = watchDueIndices[start + d];
+        int changed = (watchChangedMask[d / 32] & (1u << (d % 32))) != 0;
+
+        if (watchDropped[index] == WATCH_DROPPED)
+            continue;
+
+        // the first poll after mouse input restarts the entry at the highest rate
+        if (watchEpochs[index] != inputEpoch)
+        {
+            watchEpochs[index] = inputEpoch;
+            watchIntervals[index] = POLL_MIN_TICKS;
+        }
+
+        // a debounced change has to stay the same in further polls before it is taken over, until then the entry is polled at the highest rate
+        if (changed != 0 && watchDebounce[index] > 0 && DebounceChange(index, watchDueKeys[start + d]) != 0)
+        {
+            watchIntervals[index] = POLL_MIN_TICKS;
+            InsertWatch(index, POLL_MIN_TICKS);
+            continue;
+        }
+        watchPendingPolls[index] = 0;
+
+        if (changed != 0)
+        {
+            watchIntervals[index] = POLL_MIN_TICKS;
+
+            if (scanChangedIndex < 0 || index < scanChangedIndex)
+            {
+                scanChangedIndex = index;
+                scanChangedValue = watchValues[start + d];
+            }
+        }
+        else if (watchIntervals[index] < POLL_MAX_TICKS)
+            watchIntervals[index] *= 2;
+
+        watchLastValues[index] = watchValues[start + d];
+        watchLastKeys[index] = watchDueKeys[start + d];
+        InsertWatch(index, watchIntervals[index]);
+    }
+
+    scanPosition += count;
+}
+
+// take the current values of the next chunk of entries over as their baseline
+static void BaselineChunk(void)
+{
+    int end = watchCount - baselinePosition < SCAN_CHUNK_SIZE ? watchCount : baselinePosition + SCAN_CHUNK_SIZE;
+
+    for (int i = baselinePosition; i < end; i++)
+    {
+        if (watchDropped[i] == WATCH_DROPPED || (watchAliasPrimary[i] >= 0 && watchAliasStates[i] == ALIAS_CONFIRMED))
+            continue;
+
+        // a confirmed alias takes the baseline of its pilot entry over instead of being read
+        float value = ReadWrappedWatch(i);
+        SetWatchBaseline(i, value);
+        int secondary = watchAliasSecondary[i];
+        if (secondary >= 0 && watchAliasStates[secondary] == ALIAS_CONFIRMED)
+            SetWatchBaseline(secondary, value);
+    }
+
+    baselinePosition = end;
+}
+
+// take baseline chunks until all entries have one or the scan budget counted from the given start is spent - at least one chunk so the baseline always makes progress, returns 1 once it is complete
+static int TakeBaseline(double startTime)
+{
+    while (baselinePosition < watchCount)
+    {
+        BaselineChunk();
+        if (GetMonotonicTime() - startTime >= scanBudget)
+            break;
+    }
+
+    return baselinePosition == watchCount;
+}
+
+// scheduler task that handles which hint is displayed when
+static float PollWatchesTask(float currentTime)
+{
+    // the baseline comes first, entries compared to an old one would report changes that happened while polling was asleep
+    double startTime = GetMonotonicTime();
+    if (TakeBaseline(startTime) == 0)
+        return -1.0f;
+
+    // start a new tick once all due entries of the previous one have been scanned
+    if (scanPosition == scanCount)
+    {
+        scanCount = CollectDueWatches();
+        if (droppedWatchCount != 0 && governorLevel < GOVERNOR_DROP_EXPENSIVE)
+            RestoreDroppedWatches();
+
+        scanPosition = 0;
+        scanTickTime = currentTime;
+    }
+
+    // scan as many chunks as fit into the budget - at least one so the scan always makes progress
+    do
+        ScanChunk();
+    while (scanPosition < scanCount && GetMonotonicTime() - startTime < scanBudget);
+
+    // the time between the tick and the frame its last entries are read in is the worst detection latency of that tick
+    if (currentTime - scanTickTime > worstScanLatency)
+        worstScanLatency = currentTime - scanTickTime;
 
-    if (changeDetected != 0 && ((XPLMGetElapsedTime() - lastMouseUsageTime < 1.0f) || (lastChangeDetected != 0 && forceDisplay != 0)))
+    if (scanPosition < scanCount)
+        return -1.0f;
+
+    // the entry with the lowest index wins if several changed during the tick
+    int changeDetected = 0;
+    if (watchPrimed != 0 && scanChangedIndex >= 0)
+    {
+        DisplayWatchHint(scanChangedIndex, scanChangedValue);
+        changeDetected = 1;
+    }
+    watchPrimed = 1;
+    scanChangedIndex = -1;
+
+    if (changeDetected != 0 && ((currentTime - lastInputTime < POLL_BURST_DURATION) || (lastChangeDetected != 0 && forceDisplay != 0)))
         forceDisplay = 1;
     else
         forceDisplay = 0;
 
-    lastDgDriftVacDeg = dgDriftVacDeg;
-    lastDgDriftEleDeg = dgDriftEleDeg;
-    lastDgDriftVac2Deg = dgDriftVac2Deg;
-    lastDgDriftEle2Deg = dgDriftEle2Deg;
-    lastHeadingDialDegMagPilot = headingDialDegMagPilot;
-    lastHeadingDialDegMagCopilot = headingDialDegMagCopilot;
-    lastBarometerSettingInHgPilot = barometerSettingInHgPilot;
-    lastBarometerSettingInHgCopilot = barometerSettingInHgCopilot;
-    lastAdf1CardHeadingDegMagPilot = adf1CardHeadingDegMagPilot;
-    lastAdf2CardHeadingDegMagPilot = adf2CardHeadingDegMagPilot;
-    lastAdf1CardHeadingDegMagCopilot = adf1CardHeadingDegMagCopilot;
-    lastAdf2CardHeadingDegMagCopilot = adf2CardHeadingDegMagCopilot;
-    lastHsiObsDegMagPilot = hsiObsDegMagPilot;
-    lastHsiObsDegMagCopilot = hsiObsDegMagCopilot;
-    lastNav1ObsDegMagPilot = nav1ObsDegMagPilot;
-    lastNav2ObsDegMagPilot = nav2ObsDegMagPilot;
-    lastNav1ObsDegMagCopilot = nav1ObsDegMagCopilot;
-    lastNav2ObsDegMagCopilot = nav2ObsDegMagCopilot;
-
     lastChangeDetected = changeDetected;
 
-    return 0.1f;
+    // keep polling while the burst lasts or changes keep coming in, otherwise sleep until the next mouse input
+    if (currentTime < pollBurstEndTime || forceDisplay != 0)
+        return GetPollInterval();
+
+    return 0.0f;
+}
+
+// scheduler task that reads the watch table entries of the commands that fired since the last frame
+static float ReadCommandWatchesTask(float currentTime)
+{
+    int changedIndex = -1, pendingCount = 0;
+    float changedValue = 0.0f;
+
+    for (int i = 0; i < commandWatchCount; i++)
+    {
+        int index = commandWatchIndices[i];
+        if (watchDropped[index] == WATCH_DROPPED)
+            continue;
+
+        float value = ReadWrappedWatch(index);
+        if (watchFiltered[index] != 0)
+            value = FilterValue(index, value);
+        int key = QuantizeWatch(index, value);
+
+        // a debounced change has to stay the same in the reads of further frames before it is taken over
+        if (key != watchLastKeys[index] && watchDebounce[index] > 0 && DebounceChange(index, key) != 0)
+        {
+            commandWatchIndices[pendingCount++] = index;
+            continue;
+        }
+        watchPendingPolls[index] = 0;
+
+        if (key != watchLastKeys[index] && (changedIndex < 0 || index < changedIndex))
+        {
+            changedIndex = index;
+            changedValue = value;
+        }
+
+        watchLastValues[index] = value;
+        watchLastKeys[index] = key;
+    }
+    commandWatchCount = pendingCount;
+
+    if (changedIndex >= 0)
+        DisplayWatchHint(changedIndex, changedValue);
+
+    return pendingCount > 0 ? -1.0f : 0.0f;
+}
+
+// record mouse usage at the frame time the caller set and start polling the watched datarefs at the highest rate - if polling was asleep the current values become the baseline, as far as the scan budget allows right away and for the remaining entries in the next polls
+static void HandleMouseUsage(void)
+{
+    ProbeStart probeStart;
+    BeginProbe(PROBE_MOUSE_INPUT, &probeStart);
+
+    lastInputTime = frameTime;
+
+    if (lastInputTime >= pollBurstEndTime && forceDisplay == 0)
+    {
+        baselinePosition = 0;
+        TakeBaseline(GetMonotonicTime());
+        watchPrimed = 1;
+        lastChangeDetected = 0;
+
+        ScheduleTask(TASK_POLL_WATCHES, GetPollInterval());
+    }
+
+    // any input may change any dataref, so every entry is due at the next tick - their poll intervals drop to the minimum when they are polled
+    inputEpoch++;
+    CollapseWheel();
+
+    pollBurstEndTime = lastInputTime + POLL_BURST_DURATION;
+
+    EndProbe(PROBE_MOUSE_INPUT, &probeStart);
 }
 
-// draw-callback that performs the actual drawing of the hint
+// draw-callback that performs the actual drawing of the hint - only registered while a hint has not expired
 static int DrawCallback(XPLMDrawingPhase inPhase, int inIsBefore, void *inRefcon)
 {
-    float currentTime = XPLMGetElapsedTime();
+    ProbeStart probeStart;
+    BeginProbe(PROBE_DRAW, &probeStart);
+
+    drawCallbackCalls++;
+    USDT_PROBE2(draw, hintVisible, hintVertexCount);
 
-    if ((currentTime - lastMouseUsageTime <= HINT_DURATION || forceDisplay != 0) && currentTime - lastHintTime <= HINT_DURATION)
+    if (hintVisible != 0)
     {
-        float color[] = {1.0f, 1.0f, 1.0f};
         int x = 0, y = 0;
         XPLMGetMouseLocation(&x, &y);
-        XPLMDrawString(color, x + 40, y - 40, hintText, NULL, xplmFont_Basic);
+
+        FormatHint();
+        if (hintLayoutDirty != 0)
+        {
+            hintVertexCount = LayoutText(hintText, hintVertices, hintTexCoords, HINT_TEXT_LENGTH);
+            hintLayoutDirty = 0;
+        }
+
+        // text with characters that are not in the glyph atlas is left to X-Plane's font renderer
+        if (hintVertexCount < 0)
+        {
+            float color[] = {1.0f, 1.0f, 1.0f};
+            XPLMDrawString(color, x + HINT_OFFSET_X, y + HINT_OFFSET_Y, hintText, NULL, xplmFont_Basic);
+        }
+        else
+        {
+            if (glyphAtlasTexture == 0)
+                CreateGlyphAtlas();
+
+            XPLMSetGraphicsState(0, 1, 0, 0, 1, 0, 0);
+            XPLMBindTexture2d(glyphAtlasTexture, 0);
+            glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+            glPushMatrix();
+            glTranslatef((float) (x + HINT_OFFSET_X), (float) (y + HINT_OFFSET_Y), 0.0f);
+            glEnableClientState(GL_VERTEX_ARRAY);
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+            glVertexPointer(2, GL_FLOAT, 0, hintVertices);
+            glTexCoordPointer(2, GL_FLOAT, 0, hintTexCoords);
+            glDrawArrays(GL_QUADS, 0, hintVertexCount);
+            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+            glDisableClientState(GL_VERTEX_ARRAY);
+            glPopMatrix();
+        }
     }
 
+    EndProbe(PROBE_DRAW, &probeStart);
+
     return 1;
 }
 
+// scheduler task that decides once per frame whether the hint is visible and keeps the draw-callback registered only until the hint expires
+static float UpdateHintTask(float currentTime)
+{
+    // while the governor suspends drawing the hint is handled as if it expired
+    if (currentTime - lastHintTime > HINT_DURATION || governorLevel >= GOVERNOR_SUSPEND_DRAWING)
+    {
+        hintVisible = 0;
+
+        if (drawCallbackRegistered != 0)
+        {
+            XPLMUnregisterDrawCallback(DrawCallback, xplm_Phase_LastCockpit, 0, NULL);
+            drawCallbackRegistered = 0;
+        }
+
+        return 0.0f;
+    }
+
+    hintVisible = currentTime - lastInputTime <= HINT_DURATION || forceDisplay != 0;
+
+    if (drawCallbackRegistered == 0)
+    {
+        XPLMRegisterDrawCallback(DrawCallback, xplm_Phase_LastCockpit, 0, NULL);
+        drawCallbackRegistered = 1;
+    }
+
+    return -1.0f;
+}
+
 static void DrawWindow(XPLMWindowID inWindowID, void *inRefcon)
 {
 }
@@ -237,7 +3008,11 @@ static void HandleKey(XPLMWindowID inWindowID, char inKey, XPLMKeyFlags inFlags,
 
 static int HandleMouseClick(XPLMWindowID inWindowID, int x, int y, XPLMMouseStatus inMouse, void *inRefcon)
 {
-    lastMouseUsageTime = XPLMGetElapsedTime();
+    frameTime = XPLMGetElapsedTime();
+    if (sessionFile != NULL)
+        RecordMouse(SESSION_RECORD_CLICK, x, y, inMouse, 0);
+
+    HandleMouseUsage();
 
     return 0;
 }
@@ -249,7 +3024,11 @@ static XPLMCursorStatus HandleCursor(XPLMWindowID inWindowID, int x, int y, void
 
 static int HandleMouseWheel(XPLMWindowID inWindowID, int x, int y, int wheel, int clicks, void *inRefcon)
 {
-    lastMouseUsageTime = XPLMGetElapsedTime();
+    frameTime = XPLMGetElapsedTime();
+    if (sessionFile != NULL)
+        RecordMouse(SESSION_RECORD_WHEEL, x, y, wheel, clicks);
+
+    HandleMouseUsage();
 
     return 0;
 }
@@ -261,25 +3040,79 @@ PLUGIN_API int XPluginStart(char *outName, char *outSig, char *outDesc)
     strcpy(outSig, "de.bwravencl." NAME_LOWERCASE);
     strcpy(outDesc, NAME " simpliefies handling X-Plane by adding tooltips!");
 
-    // obtain datarefs
-    dgDriftVacDegDataRef = XPLMFindDataRef("sim/cockpit/gyros/dg_drift_vac_deg");
-    dgDriftEleDegDataRef = XPLMFindDataRef("sim/cockpit/gyros/dg_drift_ele_deg");
-    dgDriftVac2DegDataRef = XPLMFindDataRef("sim/cockpit/gyros/dg_drift_vac2_deg");
-    dgDriftEle2DegDataRef = XPLMFindDataRef("sim/cockpit/gyros/dg_drift_ele2_deg");
-    headingDialDegMagPilotDataRef = XPLMFindDataRef("sim/cockpit2/autopilot/heading_dial_deg_mag_pilot");
-    headingDialDegMagCopilotDataRef = XPLMFindDataRef("sim/cockpit2/autopilot/heading_dial_deg_mag_copilot");
-    barometerSettingInHgPilotDataRef = XPLMFindDataRef("sim/cockpit2/gauges/actuators/barometer_setting_in_hg_pilot");
-    barometerSettingInHgCopilotDataRef = XPLMFindDataRef("sim/cockpit2/gauges/actuators/barometer_setting_in_hg_copilot");
-    adf1CardHeadingDegMagPilotDataRef = XPLMFindDataRef("sim/cockpit2/radios/actuators/adf1_card_heading_deg_mag_pilot");
-    adf2CardHeadingDegMagPilotDataRef = XPLMFindDataRef("sim/cockpit2/radios/actuators/adf2_card_heading_deg_mag_pilot");
-    adf1CardHeadingDegMagCopilotDataRef = XPLMFindDataRef("sim/cockpit2/radios/actuators/adf1_card_heading_deg_mag_copilot");
-    adf2CardHeadingDegMagCopilotDataRef = XPLMFindDataRef("sim/cockpit2/radios/actuators/adf2_card_heading_deg_mag_copilot");
-    hsiObsDegMagPilotDataRef = XPLMFindDataRef("sim/cockpit2/radios/actuators/hsi_obs_deg_mag_pilot");
-    hsiObsDegMagCopilotDataRef = XPLMFindDataRef("sim/cockpit2/radios/actuators/hsi_obs_deg_mag_copilot");
-    nav1ObsDegMagPilotDataRef = XPLMFindDataRef("sim/cockpit2/radios/actuators/nav1_obs_deg_mag_pilot");
-    nav2ObsDegMagPilotDataRef = XPLMFindDataRef("sim/cockpit2/radios/actuators/nav2_obs_deg_mag_pilot");
-    nav1ObsDegMagCopilotDataRef = XPLMFindDataRef("sim/cockpit2/radios/actuators/nav1_obs_deg_mag_copilot");
-    nav2ObsDegMagCopilotDataRef = XPLMFindDataRef("sim/cockpit2/radios/actuators/nav2_obs_deg_mag_copilot");
+    // use native paths and find the plugin's folder that holds the config and session files
+    if (XPLMHasFeature("XPLM_USE_NATIVE_PATHS") != 0)
+        XPLMEnableFeature("XPLM_USE_NATIVE_PATHS", 1);
+    ResolvePluginPath();
+
+    // publish latency statistics
+    RegisterPerfDataRefs();
+
+    // set up suppression rules - the QPAC A320 shows its own hints for headings and drifts
+    AddSuppressionRule(QPAC_A320_PLUGIN_SIGNATURE, WATCH_KIND_BIT(WATCH_KIND_DRIFT) | WATCH_KIND_BIT(WATCH_KIND_HEADING));
+    LoadConfig();
+
+    // select change-detection kernel
+    SelectKernels();
+
+    // fill watch table - the order defines which hint wins if several datarefs change at once, watches from the config file come first and replace built-in watches of the same dataref
+    AddBuiltInWatch("sim/cockpit/gyros/dg_drift_vac_deg", WATCH_KIND_DRIFT, DRIFT_QUANTUM);
+    AddBuiltInWatch("sim/cockpit/gyros/dg_drift_ele_deg", WATCH_KIND_DRIFT, DRIFT_QUANTUM);
+    AddBuiltInWatch("sim/cockpit/gyros/dg_drift_vac2_deg", WATCH_KIND_DRIFT, DRIFT_QUANTUM);
+    AddBuiltInWatch("sim/cockpit/gyros/dg_drift_ele2_deg", WATCH_KIND_DRIFT, DRIFT_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/autopilot/heading_dial_deg_mag_pilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/autopilot/heading_dial_deg_mag_copilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/gauges/actuators/barometer_setting_in_hg_pilot", WATCH_KIND_BAROMETER, BAROMETER_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/gauges/actuators/barometer_setting_in_hg_copilot", WATCH_KIND_BAROMETER, BAROMETER_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/radios/actuators/adf1_card_heading_deg_mag_pilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/radios/actuators/adf2_card_heading_deg_mag_pilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/radios/actuators/adf1_card_heading_deg_mag_copilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/radios/actuators/adf2_card_heading_deg_mag_copilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/radios/actuators/hsi_obs_deg_mag_pilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/radios/actuators/hsi_obs_deg_mag_copilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/radios/actuators/nav1_obs_deg_mag_pilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/radios/actuators/nav2_obs_deg_mag_pilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/radios/actuators/nav1_obs_deg_mag_copilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+    AddBuiltInWatch("sim/cockpit2/radios/actuators/nav2_obs_deg_mag_copilot", WATCH_KIND_HEADING, HEADING_QUANTUM);
+
+    // pilot and copilot instruments that many planes drive from the same value
+    PairWatches("sim/cockpit2/autopilot/heading_dial_deg_mag_pilot", "sim/cockpit2/autopilot/heading_dial_deg_mag_copilot");
+    PairWatches("sim/cockpit2/gauges/actuators/barometer_setting_in_hg_pilot", "sim/cockpit2/gauges/actuators/barometer_setting_in_hg_copilot");
+    PairWatches("sim/cockpit2/radios/actuators/adf1_card_heading_deg_mag_pilot", "sim/cockpit2/radios/actuators/adf1_card_heading_deg_mag_copilot");
+    PairWatches("sim/cockpit2/radios/actuators/adf2_card_heading_deg_mag_pilot", "sim/cockpit2/radios/actuators/adf2_card_heading_deg_mag_copilot");
+    PairWatches("sim/cockpit2/radios/actuators/hsi_obs_deg_mag_pilot", "sim/cockpit2/radios/actuators/hsi_obs_deg_mag_copilot");
+    PairWatches("sim/cockpit2/radios/actuators/nav1_obs_deg_mag_pilot", "sim/cockpit2/radios/actuators/nav1_obs_deg_mag_copilot");
+    PairWatches("sim/cockpit2/radios/actuators/nav2_obs_deg_mag_pilot", "sim/cockpit2/radios/actuators/nav2_obs_deg_mag_copilot");
+
+    // noise filters from the config file apply to built-in watches as well
+    ApplyFilterRules(0, 0);
+
+    // every entry is due at the first tick of polling
+    ResetWheel();
+
+    // bind the knob commands of the built-in watches so keyboard and joystick input produces hints too - bindings from the config file were added before
+    AddCommandBinding("sim/autopilot/heading_up", "sim/cockpit2/autopilot/heading_dial_deg_mag_pilot");
+    AddCommandBinding("sim/autopilot/heading_down", "sim/cockpit2/autopilot/heading_dial_deg_mag_pilot");
+    AddCommandBinding("sim/instruments/barometer_up", "sim/cockpit2/gauges/actuators/barometer_setting_in_hg_pilot");
+    AddCommandBinding("sim/instruments/barometer_down", "sim/cockpit2/gauges/actuators/barometer_setting_in_hg_pilot");
+    AddCommandBinding("sim/radios/adf1_card_up", "sim/cockpit2/radios/actuators/adf1_card_heading_deg_mag_pilot");
+    AddCommandBinding("sim/radios/adf1_card_down", "sim/cockpit2/radios/actuators/adf1_card_heading_deg_mag_pilot");
+    AddCommandBinding("sim/radios/adf2_card_up", "sim/cockpit2/radios/actuators/adf2_card_heading_deg_mag_pilot");
+    AddCommandBinding("sim/radios/adf2_card_down", "sim/cockpit2/radios/actuators/adf2_card_heading_deg_mag_pilot");
+    AddCommandBinding("sim/radios/obs_HSI_up", "sim/cockpit2/radios/actuators/hsi_obs_deg_mag_pilot");
+    AddCommandBinding("sim/radios/obs_HSI_down", "sim/cockpit2/radios/actuators/hsi_obs_deg_mag_pilot");
+    AddCommandBinding("sim/radios/obs1_up", "sim/cockpit2/radios/actuators/nav1_obs_deg_mag_pilot");
+    AddCommandBinding("sim/radios/obs1_down", "sim/cockpit2/radios/actuators/nav1_obs_deg_mag_pilot");
+    AddCommandBinding("sim/radios/obs2_up", "sim/cockpit2/radios/actuators/nav2_obs_deg_mag_pilot");
+    AddCommandBinding("sim/radios/obs2_down", "sim/cockpit2/radios/actuators/nav2_obs_deg_mag_pilot");
+    RegisterCommandBindings(0);
+
+    // describe the complete watch table at the start of the session
+    if (sessionFile != NULL)
+    {
+        RecordWatches(0);
+        RecordCommandBindings(0);
+    }
 
     // create fake window
     XPLMCreateWindow_t fakeWindowParameters;
@@ -298,25 +3131,103 @@ PLUGIN_API int XPluginStart(char *outName, char *outSig, char *outDesc)
     fakeWindowParameters.handleCursorFunc = HandleCursor;
     fakeWindowParameters.handleMouseWheelFunc = HandleMouseWheel;
     fakeWindow = XPLMCreateWindowEx(&fakeWindowParameters);
+    fakeWindowWidth = x;
+    fakeWindowHeight = y;
 
-    // register flight loop callbacks
-    XPLMRegisterFlightLoopCallback(UpdateFakeWindowCallback, -1, NULL);
-    XPLMRegisterFlightLoopCallback(FlightLoopCallback, -1, NULL);
+    // set up scheduler tasks - watches are only polled after mouse input or read after commands and the hint is only updated while it has not expired
+    schedulerTasks[TASK_UPDATE_FAKE_WINDOW] = UpdateFakeWindowTask;
+    schedulerTasks[TASK_POLL_WATCHES] = PollWatchesTask;
+    schedulerTasks[TASK_UPDATE_HINT] = UpdateHintTask;
+    schedulerTasks[TASK_READ_COMMAND_WATCHES] = ReadCommandWatchesTask;
+    frameTime = XPLMGetElapsedTime();
+    SetTaskDeadline(TASK_UPDATE_FAKE_WINDOW, -1.0f, frameTime);
+    SetTaskDeadline(TASK_POLL_WATCHES, 0.0f, frameTime);
+    SetTaskDeadline(TASK_UPDATE_HINT, 0.0f, frameTime);
+    SetTaskDeadline(TASK_READ_COMMAND_WATCHES, 0.0f, frameTime);
 
-    // register draw callback
-    XPLMRegisterDrawCallback(DrawCallback, xplm_Phase_LastCockpit, 0, NULL);
+    // create scheduler flight loop that runs after the flight model
+    XPLMCreateFlightLoop_t schedulerParameters;
+    memset(&schedulerParameters, 0, sizeof(schedulerParameters));
+    schedulerParameters.structSize = sizeof(schedulerParameters);
+    schedulerParameters.phase = xplm_FlightLoop_Phase_AfterFlightModel;
+    schedulerParameters.callbackFunc = SchedulerCallback;
+    schedulerParameters.refcon = NULL;
+    schedulerFlightLoop = XPLMCreateFlightLoop(&schedulerParameters);
+    XPLMScheduleFlightLoop(schedulerFlightLoop, -1.0f, 1);
 
     return 1;
 }
 
 PLUGIN_API void XPluginStop(void)
 {
-    // unregister flight loop callbacks
-    XPLMUnregisterFlightLoopCallback(UpdateFakeWindowCallback, NULL);
-    XPLMUnregisterFlightLoopCallback(FlightLoopCallback, NULL);
+    // destroy scheduler flight loop
+    XPLMDestroyFlightLoop(schedulerFlightLoop);
+    schedulerFlightLoop = NULL;
+
+    // unregister draw callback if a hint is still shown
+    if (drawCallbackRegistered != 0)
+    {
+        XPLMUnregisterDrawCallback(DrawCallback, xplm_Phase_LastCockpit, 0, NULL);
+        drawCallbackRegistered = 0;
+    }
+    hintVisible = 0;
+
+    // delete glyph atlas
+    if (glyphAtlasTexture != 0)
+    {
+        GLuint texture = glyphAtlasTexture;
+        glDeleteTextures(1, &texture);
+        glyphAtlasTexture = 0;
+    }
+
+    // report how often the draw callback ran - it must not grow while no hint is shown
+    char message[64];
+    sprintf(message, NAME ": draw callback ran %lu times\n", drawCallbackCalls);
+    XPLMDebugString(message);
 
-    // unregister draw callback
-    XPLMUnregisterDrawCallback(DrawCallback, xplm_Phase_LastCockpit, 0, NULL);
+    // unregister command handlers
+    UnregisterCommandBindings();
+
+    // withdraw latency statistics
+    UnregisterPerfDataRefs();
+
+    // finish trace file
+    StopTracing();
+
+    // free watch table and forget the state of an unfinished scan
+    ClearWatches();
+    scanPosition = 0;
+    scanCount = 0;
+    scanChangedIndex = -1;
+    baselinePosition = 0;
+
+    // close session file
+    StopRecording();
+
+    // write profile
+    if (profiling != 0)
+    {
+        WriteProfile();
+        profiling = 0;
+    }
+    worstScanLatency = 0.0f;
+
+    // forget suppression and filter rules, unresolved config lines and the budgets from the config file
+    suppressionRuleCount = 0;
+    suppressedKinds = 0;
+    filterRuleCount = 0;
+    pendingLineCount = 0;
+    scanBudget = SCAN_BUDGET;
+    frameBudget = GOVERNOR_BUDGET;
+
+    // start the governor at full operation again
+    governorLevel = GOVERNOR_FULL_OPERATION;
+    governorOverruns = 0;
+    governorRecovered = 0;
+    governorRecoveryTime = GOVERNOR_RECOVERY_TIME;
+    governorTicks = 0;
+    governorWorstTicks = 0;
+    governorCycle = 0;
 }
 
 PLUGIN_API void XPluginDisable(void)
@@ -325,11 +3236,31 @@ PLUGIN_API void XPluginDisable(void)
 
 PLUGIN_API int XPluginEnable(void)
 {
+    RefreshSuppressedKinds();
+
     return 1;
 }
 
 PLUGIN_API void XPluginReceiveMessage(XPLMPluginID inFromWho, long inMessage, void *inParam)
 {
     if (inMessage == XPLM_MSG_PLANE_LOADED)
+    {
+        frameTime = XPLMGetElapsedTime();
+        if (sessionFile != NULL)
+            WriteSessionRecordHeader(SESSION_RECORD_PLANE_LOADED);
+
         bringFakeWindowToFront = 0;
+        ScheduleTask(TASK_UPDATE_FAKE_WINDOW, -1.0f);
+        RefreshSuppressedKinds();
+        ResolvePendingLines();
+        ResetAliases();
+    }
+    else if (inMessage == XPLM_MSG_PLANE_UNLOADED)
+    {
+        frameTime = XPLMGetElapsedTime();
+        if (sessionFile != NULL)
+            WriteSessionRecordHeader(SESSION_RECORD_PLANE_UNLOADED);
+
+        RefreshSuppressedKinds();
+    }
 }